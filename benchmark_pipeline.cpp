@@ -0,0 +1,518 @@
+/**
+ * Micro-benchmarks of the pipeline stages and summaries of batch runs
+ *
+ * Usage:
+ *   ./benchmark_pipeline stages <model.psas> <observation_file> <planner_log> [options]
+ *   ./benchmark_pipeline summary <batch_checkpoint.txt> [--json <file>]
+ *   ./benchmark_pipeline progression <model.psas> [--repeat <n>] [--steps <n>] [--json <file>]
+ *
+ * stages times every step the driver runs on an observation problem, each
+ * one --repeat times on the same input:
+ *   model_read        Model::read of the grounded model
+ *   prefix_encoding   encodePrefix of the observations, without (cold) and
+ *                     with (warm) the model sections cached by the encoder
+ *   log_parse         parsePlannerLog of the planner log
+ *   tree_parse        parseDecompositionTreeFromLog
+ *   ordering          extractOrderingConstraints and computeOrderingRelation
+ *                     of the methods used in the tree
+ *   stage2, stage3    the log-space Stage II and Stage III probabilities
+ * and writes the median, 95th percentile, minimum and maximum in ms per
+ * stage and the peak resident set size of the process as JSON.
+ *
+ * summary reads the checkpoint of a batch whose jobs are named
+ * <case>/run_<r> (see run_benchmarks.sh) and writes the median and 95th
+ * percentile of the wall time and the peak RSS of every case as JSON.
+ *
+ * progression replays a fixed pseudo-random walk of --steps progressions
+ * (default: 100000) with Model::decompose and Model::apply from the initial
+ * task network, keeps every node like the open and visited lists of a search
+ * do, deletes them all and releases the NodePool. The replay is timed --repeat
+ * times with the searchNode / planStep / solutionStep allocations from the
+ * NodePool and from operator new, both walks are the same.
+ *
+ * Options of stages:
+ *   --repeat <n>      repetitions per stage (default: 10)
+ *   --num-obs <n>     observations used (default: all)
+ *   --partial-obs     Stage III under partial observability
+ *   --p-det <p>       detection probability for partial obs (default: 0.9)
+ *   --pgrpo           encode for the partially ordered PGR problem
+ *   --read-threads <n> threads of Model::read (default: all cores)
+ *   --json <file>     write the result to file instead of stdout
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "htnModel/Model.h"
+#include "prefEncoding/GroundPrefixEncoding.h"
+#include "likelihood/NormalizedLikelihood.h"
+#include "posterior/TextUtil.h"
+
+using namespace std;
+using namespace progression;
+
+struct TimingStats {
+    int samples = 0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// nearest-rank percentiles
+static TimingStats statsOf(vector<double> values) {
+    TimingStats stats;
+    if (values.empty()) {
+        return stats;
+    }
+    sort(values.begin(), values.end());
+    size_t n = values.size();
+    stats.samples = n;
+    stats.median = (n % 2 == 1) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    stats.p95 = values[min(n - 1, (size_t) ((95 * n + 99) / 100) - 1)];
+    stats.min = values.front();
+    stats.max = values.back();
+    return stats;
+}
+
+static long peakRssKB() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// swallows what the stages print while they are timed
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// runs step repeat times and returns the time of every run in ms
+static vector<double> timeStep(int repeat, const function<void()>& step) {
+    vector<double> times;
+    NullBuffer null;
+    streambuf* saved = cout.rdbuf(&null);
+    for (int r = 0; r < repeat; r++) {
+        auto start = chrono::steady_clock::now();
+        step();
+        auto end = chrono::steady_clock::now();
+        times.push_back(chrono::duration<double, milli>(end - start).count());
+    }
+    cout.rdbuf(saved);
+    return times;
+}
+
+static string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static void writeStats(ostream& out, const TimingStats& stats) {
+    out << "{\"samples\": " << stats.samples << ", \"median\": " << stats.median << ", \"p95\": " << stats.p95
+        << ", \"min\": " << stats.min << ", \"max\": " << stats.max << "}";
+}
+
+// ============================================================================
+// STAGES
+// ============================================================================
+
+struct StageOptions {
+    int repeat = 10;
+    int numObs = -1;
+    bool fullObservability = true;
+    double pDet = 0.9;
+    encodingType encoding = PGRfo;
+    string jsonFile;
+};
+
+static int benchmarkStages(const string& modelFile, const string& observationFile, const string& logFile,
+                           const StageOptions& options) {
+    vector<pair<string, vector<double>>> stages;
+    int repeat = max(options.repeat, 1);
+
+    Model* htn = nullptr;
+    stages.emplace_back("model_read", timeStep(repeat, [&]() {
+        delete htn;
+        htn = new Model();
+        htn->read(modelFile);
+    }));
+
+    GroundPrefixEncoding encoder;
+    vector<string> observations;
+    vector<int> observationIds;
+    if (!encoder.readSolution(observationFile, observations, -1) || !encoder.mapPlan(htn, observations, observationIds)) {
+        cerr << "Error: Cannot map the observations in " << observationFile << " to the model" << endl;
+        delete htn;
+        return 1;
+    }
+    size_t numObs = (options.numObs < 0) ? observationIds.size() : min(observationIds.size(), (size_t) options.numObs);
+    vector<int> prefix(observationIds.begin(), observationIds.begin() + numObs);
+
+    encodingResult encoded = EncodingWritten;
+    stages.emplace_back("prefix_encoding_cold", timeStep(repeat, [&]() {
+        encoder.clearCache();
+        ostringstream pgr;
+        encoded = encoder.encodePrefix(htn, prefix, options.encoding, false, pgr);
+    }));
+    stages.emplace_back("prefix_encoding_warm", timeStep(repeat, [&]() {
+        ostringstream pgr;
+        encoded = encoder.encodePrefix(htn, prefix, options.encoding, false, pgr);
+    }));
+    encoder.clearCache();
+    if (encoded == EncodingFailed) {
+        cerr << "Error: Encoding of the observations failed" << endl;
+        delete htn;
+        return 1;
+    }
+
+    string logText;
+    if (!readTextFile(logFile, logText)) {
+        cerr << "Error: Cannot open log file: " << logFile << endl;
+        delete htn;
+        return 1;
+    }
+    ParsedLog log;
+    stages.emplace_back("log_parse", timeStep(repeat, [&]() {
+        log = parsePlannerLog(logText);
+    }));
+    vector<int> plan = planToActionIds(htn, log);
+    if (plan.empty()) {
+        cerr << "Error: No plan found in log file: " << logFile << endl;
+        delete htn;
+        return 1;
+    }
+
+    set<int> usedMethods;
+    stages.emplace_back("tree_parse", timeStep(repeat, [&]() {
+        usedMethods.clear();
+        parseDecompositionTreeFromLog(log, htn, &usedMethods);
+    }));
+
+    size_t numConstraints = 0;
+    stages.emplace_back("ordering_constraints", timeStep(repeat, [&]() {
+        numConstraints = extractOrderingConstraints(htn, &usedMethods).size();
+    }));
+    OrderingRelation orderings;
+    stages.emplace_back("ordering_relation", timeStep(repeat, [&]() {
+        orderings = computeOrderingRelation(htn, &usedMethods);
+    }));
+
+    double logStage2 = 0.0;
+    stages.emplace_back("stage2", timeStep(repeat, [&]() {
+        logStage2 = computeStage2LogProbability(htn, plan, orderings, false);
+    }));
+
+    vector<int> observed(plan.begin(), plan.begin() + min(plan.size(), numObs));
+    double logStage3 = 0.0;
+    stages.emplace_back("stage3", timeStep(repeat, [&]() {
+        logStage3 = computeStage3LogProbability(observed, plan, options.fullObservability, options.pDet, htn, false);
+    }));
+
+    ofstream file;
+    if (!options.jsonFile.empty()) {
+        file.open(options.jsonFile);
+        if (!file.is_open()) {
+            cerr << "Error: Cannot write " << options.jsonFile << endl;
+            delete htn;
+            return 1;
+        }
+    }
+    ostream& out = options.jsonFile.empty() ? cout : file;
+    out << setprecision(6);
+    out << "{" << endl;
+    out << "  \"model\": " << jsonString(modelFile) << "," << endl;
+    out << "  \"observations\": " << jsonString(observationFile) << "," << endl;
+    out << "  \"planner_log\": " << jsonString(logFile) << "," << endl;
+    out << "  \"repeat\": " << repeat << "," << endl;
+    out << "  \"num_actions\": " << htn->numActions << ", \"num_tasks\": " << htn->numTasks
+        << ", \"num_methods\": " << htn->numMethods << "," << endl;
+    out << "  \"num_obs\": " << numObs << ", \"plan_length\": " << plan.size()
+        << ", \"used_methods\": " << usedMethods.size() << ", \"ordering_constraints\": " << numConstraints << "," << endl;
+    out << "  \"log_stage2\": " << logStage2 << ", \"log_stage3\": " << logStage3 << "," << endl;
+    out << "  \"stages_ms\": {" << endl;
+    for (size_t i = 0; i < stages.size(); i++) {
+        out << "    " << jsonString(stages[i].first) << ": ";
+        writeStats(out, statsOf(stages[i].second));
+        out << ((i + 1 < stages.size()) ? "," : "") << endl;
+    }
+    out << "  }," << endl;
+    out << "  \"peak_rss_kb\": " << peakRssKB() << endl;
+    out << "}" << endl;
+
+    delete htn;
+    return 0;
+}
+
+// ============================================================================
+// PROGRESSION
+// ============================================================================
+
+struct ReplayResult {
+    long nodes = 0;
+    long restarts = 0;
+    size_t poolBytes = 0;
+};
+
+// the walk applies the first applicable primitive task and otherwise decomposes
+// the first abstract task with a method drawn from a fixed seed; it starts
+// again from the initial task network on a dead end or in a goal node
+static ReplayResult replayProgression(Model* htn, int steps) {
+    ReplayResult result;
+    vector<searchNode*> nodes;
+    nodes.reserve(steps + 1);
+    unsigned long long seed = 42;
+    searchNode* n = htn->prepareTNi(htn);
+    nodes.push_back(n);
+    for (int step = 0; step < steps; step++) {
+        searchNode* next = nullptr;
+        for (int i = 0; i < n->numPrimitive && next == nullptr; i++) {
+            if (htn->isApplicable(n, n->unconstraintPrimitive[i]->task)) {
+                next = htn->apply(n, i);
+            }
+        }
+        if (next == nullptr && n->numAbstract > 0) {
+            int task = n->unconstraintAbstract[0]->task;
+            if (htn->numMethodsForTask[task] > 0) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                int method = htn->taskToMethods[task][(seed >> 33) % htn->numMethodsForTask[task]];
+                next = htn->decompose(n, 0, method);
+            }
+        }
+        if (next == nullptr || htn->isGoal(next)) {
+            result.restarts++;
+            if (next != nullptr) {
+                nodes.push_back(next);
+            }
+            next = htn->prepareTNi(htn);
+        }
+        nodes.push_back(next);
+        n = next;
+    }
+    result.nodes = nodes.size();
+    result.poolBytes = NodePool::local().reservedBytes();
+    for (searchNode* node : nodes) {
+        delete node;
+    }
+    NodePool::local().release();
+    return result;
+}
+
+static int benchmarkProgression(const string& modelFile, int repeat, int steps, const string& jsonFile) {
+    repeat = max(repeat, 1);
+    Model* htn = new Model();
+    NullBuffer null;
+    streambuf* saved = cout.rdbuf(&null);
+    htn->read(modelFile);
+    cout.rdbuf(saved);
+
+    ReplayResult pooled, plain;
+    NodePool::local().setEnabled(true);
+    vector<double> pooledTimes = timeStep(repeat, [&]() {
+        pooled = replayProgression(htn, steps);
+    });
+    NodePool::local().setEnabled(false);
+    vector<double> plainTimes = timeStep(repeat, [&]() {
+        plain = replayProgression(htn, steps);
+    });
+    NodePool::local().setEnabled(true);
+    if (pooled.nodes != plain.nodes || pooled.restarts != plain.restarts) {
+        cerr << "Error: The replays with and without the pool differ" << endl;
+        delete htn;
+        return 1;
+    }
+
+    ofstream file;
+    if (!jsonFile.empty()) {
+        file.open(jsonFile);
+        if (!file.is_open()) {
+            cerr << "Error: Cannot write " << jsonFile << endl;
+            delete htn;
+            return 1;
+        }
+    }
+    ostream& out = jsonFile.empty() ? cout : file;
+    TimingStats pooledStats = statsOf(pooledTimes);
+    TimingStats plainStats = statsOf(plainTimes);
+    out << setprecision(6);
+    out << "{" << endl;
+    out << "  \"model\": " << jsonString(modelFile) << "," << endl;
+    out << "  \"repeat\": " << repeat << ", \"steps\": " << steps << "," << endl;
+    out << "  \"nodes\": " << pooled.nodes << ", \"restarts\": " << pooled.restarts
+        << ", \"pool_bytes\": " << pooled.poolBytes << "," << endl;
+    out << "  \"replay_ms\": {" << endl;
+    out << "    \"node_pool\": ";
+    writeStats(out, pooledStats);
+    out << "," << endl << "    \"operator_new\": ";
+    writeStats(out, plainStats);
+    out << endl << "  }," << endl;
+    out << "  \"speedup\": " << ((pooledStats.median > 0) ? plainStats.median / pooledStats.median : 0.0) << "," << endl;
+    out << "  \"peak_rss_kb\": " << peakRssKB() << endl;
+    out << "}" << endl;
+
+    delete htn;
+    return 0;
+}
+
+// ============================================================================
+// SUMMARY OF BATCH RUNS
+// ============================================================================
+
+static int summarizeCheckpoint(const string& checkpointFile, const string& jsonFile) {
+    ifstream in(checkpointFile);
+    if (!in.is_open()) {
+        cerr << "Error: Cannot open checkpoint: " << checkpointFile << endl;
+        return 1;
+    }
+
+    struct CaseRuns {
+        vector<double> seconds;
+        vector<double> rssKB;
+        int failed = 0;
+    };
+    map<string, CaseRuns> cases;
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string name, status;
+        double seconds = 0.0;
+        long rssKB = 0;
+        if (!(fields >> name >> status >> seconds >> rssKB)) {
+            continue;
+        }
+        size_t run = name.rfind("/run_");
+        CaseRuns& runs = cases[(run == string::npos) ? name : name.substr(0, run)];
+        if (status != "ok") {
+            runs.failed++;
+            continue;
+        }
+        runs.seconds.push_back(seconds);
+        runs.rssKB.push_back(rssKB);
+    }
+
+    ofstream file;
+    if (!jsonFile.empty()) {
+        file.open(jsonFile);
+        if (!file.is_open()) {
+            cerr << "Error: Cannot write " << jsonFile << endl;
+            return 1;
+        }
+    }
+    ostream& out = jsonFile.empty() ? cout : file;
+    out << setprecision(6);
+    out << "{" << endl;
+    size_t i = 0;
+    for (const auto& entry : cases) {
+        TimingStats rss = statsOf(entry.second.rssKB);
+        out << "  " << jsonString(entry.first) << ": {\"runs\": " << entry.second.seconds.size()
+            << ", \"failed\": " << entry.second.failed << ", \"seconds\": ";
+        writeStats(out, statsOf(entry.second.seconds));
+        out << ", \"peak_rss_kb\": " << (long) rss.max << ", \"median_rss_kb\": " << (long) rss.median << "}"
+            << ((++i < cases.size()) ? "," : "") << endl;
+    }
+    out << "}" << endl;
+    return 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void printUsage(const char* name) {
+    cout << "Usage: " << name << " stages <model.psas> <observation_file> <planner_log> [options]" << endl;
+    cout << "       " << name << " summary <batch_checkpoint.txt> [--json <file>]" << endl;
+    cout << "       " << name << " progression <model.psas> [--repeat <n>] [--steps <n>] [--json <file>]" << endl;
+    cout << "\nOptions of stages:" << endl;
+    cout << "  --repeat <n>   : Repetitions per stage (default: 10)" << endl;
+    cout << "  --num-obs <n>  : Number of observations to use (default: all)" << endl;
+    cout << "  --partial-obs  : Stage III under partial observability" << endl;
+    cout << "  --p-det <p>    : Detection probability for partial obs (default: 0.9)" << endl;
+    cout << "  --pgrpo        : Encode for the partially ordered PGR problem" << endl;
+    cout << "  --read-threads <n> : Threads of Model::read (default: all cores)" << endl;
+    cout << "  --json <file>  : Write the result to file instead of stdout" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string mode = (argc > 1) ? argv[1] : "";
+
+    if (mode == "summary" && argc >= 3) {
+        string jsonFile;
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--json" && i + 1 < argc) {
+                jsonFile = argv[++i];
+            } else {
+                cerr << "Error: Unknown option: " << arg << endl;
+                return 1;
+            }
+        }
+        return summarizeCheckpoint(argv[2], jsonFile);
+    }
+
+    if (mode == "progression" && argc >= 3) {
+        int repeat = 10;
+        int steps = 100000;
+        string jsonFile;
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--repeat" && i + 1 < argc) {
+                repeat = atoi(argv[++i]);
+            } else if (arg == "--steps" && i + 1 < argc) {
+                steps = atoi(argv[++i]);
+            } else if (arg == "--json" && i + 1 < argc) {
+                jsonFile = argv[++i];
+            } else {
+                cerr << "Error: Unknown option: " << arg << endl;
+                return 1;
+            }
+        }
+        return benchmarkProgression(argv[2], repeat, max(steps, 1), jsonFile);
+    }
+
+    if (mode != "stages" || argc < 5) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    StageOptions options;
+    for (int i = 5; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else if (arg == "--num-obs" && i + 1 < argc) {
+            options.numObs = atoi(argv[++i]);
+        } else if (arg == "--partial-obs") {
+            options.fullObservability = false;
+        } else if (arg == "--p-det" && i + 1 < argc) {
+            options.pDet = atof(argv[++i]);
+        } else if (arg == "--pgrpo") {
+            options.encoding = PGRpo;
+        } else if (arg == "--read-threads" && i + 1 < argc) {
+            Model::readThreads = atoi(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            options.jsonFile = argv[++i];
+        } else {
+            cerr << "Error: Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+    return benchmarkStages(argv[2], argv[3], argv[4], options);
+}
@@ -1,7 +1,9 @@
-rm compute_manual
+BINARIES="compute_normalized_likelihood compute_posterior compute_posterior_probabilities posterior_helper posterior_driver compute_monroe benchmark_pipeline"
 cd build
 # rm -rf *
-cmake ..
-make compute_manual
-mv compute_manual ../
-cd ..
\ No newline at end of file
+cmake .. -DCMAKE_BUILD_TYPE=Release
+make -j4 $BINARIES
+for BINARY in $BINARIES; do
+    mv $BINARY ../
+done
+cd ..
@@ -0,0 +1,92 @@
+/*
+ * IntArena.h
+ *
+ * Storage for the int rows of the model tables (precLists, subTasks,
+ * taskToMethods, ...). Rows are placed one after the other in large blocks,
+ * a table whose row sizes are known is laid out as one contiguous block
+ * (CSR, the row pointers being the offsets). The blocks are only freed as a
+ * whole, so a table keeps its int** interface but costs a single allocation.
+ */
+
+#ifndef INTARENA_H_
+#define INTARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+namespace progression {
+
+class IntArena {
+public:
+	IntArena() {}
+	~IntArena() {
+		clear();
+	}
+	IntArena(const IntArena&) = delete;
+	IntArena& operator=(const IntArena&) = delete;
+
+	// n ints, nullptr for n == 0
+	int* alloc(size_t n) {
+		if (n == 0)
+			return nullptr;
+		used += n;
+		if (n > blockSize / 4) { // own block, keeps the rest of the current one
+			blocks.push_back(new int[n]);
+			return blocks.back();
+		}
+		if (n > left)
+			newBlock();
+		int* res = cur;
+		cur += n;
+		left -= n;
+		return res;
+	}
+
+	// rows of the given sizes in one contiguous block, rows[i] == nullptr
+	// for empty rows (like the tables allocated row by row)
+	int** allocRows(int numRows, const int* sizes) {
+		int** rows = new int*[numRows];
+		size_t total = 0;
+		for (int i = 0; i < numRows; i++)
+			total += sizes[i];
+		int* data = alloc(total);
+		for (int i = 0; i < numRows; i++) {
+			rows[i] = (sizes[i] > 0) ? data : nullptr;
+			data += sizes[i];
+		}
+		return rows;
+	}
+
+	void clear() {
+		for (int* b : blocks)
+			delete[] b;
+		blocks.clear();
+		cur = nullptr;
+		left = 0;
+		used = 0;
+	}
+
+	size_t size() const { // number of ints handed out
+		return used;
+	}
+
+private:
+	static const size_t blockSize = 1 << 16;
+
+	vector<int*> blocks;
+	int* cur = nullptr;
+	size_t left = 0;
+	size_t used = 0;
+
+	void newBlock() {
+		cur = new int[blockSize];
+		left = blockSize;
+		blocks.push_back(cur);
+	}
+};
+
+} /* namespace progression */
+
+#endif /* INTARENA_H_ */
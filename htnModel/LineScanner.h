@@ -0,0 +1,114 @@
+/*
+ * LineScanner.h
+ *
+ * Lines and numbers of a model file held in memory, used by Model::read
+ * instead of getline and a stringstream per line. A line ends before its
+ * '\n' (a '\r' stays part of it, as with getline); numbers and tokens are
+ * separated by blanks. Nothing is copied, the text must outlive the scanner.
+ */
+
+#ifndef LINESCANNER_H_
+#define LINESCANNER_H_
+
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace progression {
+
+static inline bool isBlank(char c) {
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f');
+}
+
+// int at p after leading blanks, p is moved behind it; false (value 0) if
+// there is none before end, like operator>> on a failing stream
+static inline bool scanInt(const char*& p, const char* end, int& value) {
+	while ((p < end) && isBlank(*p))
+		p++;
+	bool negative = false;
+	if ((p < end) && ((*p == '-') || (*p == '+'))) {
+		negative = (*p == '-');
+		p++;
+	}
+	if ((p == end) || (*p < '0') || (*p > '9')) {
+		value = 0;
+		return false;
+	}
+	long long v = 0;
+	while ((p < end) && (*p >= '0') && (*p <= '9'))
+		v = v * 10 + (*p++ - '0');
+	value = (int) (negative ? -v : v);
+	return true;
+}
+
+// whitespace separated token at p, empty if there is none
+static inline string scanToken(const char*& p, const char* end) {
+	while ((p < end) && isBlank(*p))
+		p++;
+	const char* start = p;
+	while ((p < end) && !isBlank(*p))
+		p++;
+	return string(start, p - start);
+}
+
+class LineScanner {
+public:
+	LineScanner(const char* begin, const char* end) : pos(begin), end(end) {
+	}
+
+	bool atEnd() const {
+		return pos >= end;
+	}
+
+	// the next line in [line, lineEnd), false at the end of the text
+	bool next(const char*& line, const char*& lineEnd) {
+		if (pos >= end) {
+			line = lineEnd = end;
+			return false;
+		}
+		line = pos;
+		const char* nl = (const char*) memchr(pos, '\n', end - pos);
+		lineEnd = (nl == nullptr) ? end : nl;
+		pos = (nl == nullptr) ? end : nl + 1;
+		return true;
+	}
+
+	// the next line as string, empty at the end of the text
+	string nextLine() {
+		const char* line;
+		const char* lineEnd;
+		next(line, lineEnd);
+		return string(line, lineEnd - line);
+	}
+
+	// first int of the next line, 0 if there is none
+	int nextInt() {
+		const char* line;
+		const char* lineEnd;
+		next(line, lineEnd);
+		int value;
+		scanInt(line, lineEnd, value);
+		return value;
+	}
+
+	void skip(int lines) {
+		const char* line;
+		const char* lineEnd;
+		for (int i = 0; i < lines; i++)
+			next(line, lineEnd);
+	}
+
+	// start of the next line
+	const char* position() const {
+		return pos;
+	}
+
+private:
+	const char* pos;
+	const char* end;
+};
+
+} /* namespace progression */
+
+#endif /* LINESCANNER_H_ */
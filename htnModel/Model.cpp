@@ -18,6 +18,9 @@
 #include <cerrno>
 #include <cstring>
 #include <map>
+#include <algorithm>
+#include <functional>
+#include <thread>
 
 using namespace std;
 
@@ -67,6 +70,20 @@ Model::Model() {
 	methodsFirstTasks = nullptr;
 	methodsLastTasks = nullptr;
 	methodSubtaskSuccNum = nullptr;
+	strictMutexes = nullptr;
+	strictMutexesSize = nullptr;
+	mutexes = nullptr;
+	mutexesSize = nullptr;
+	invariants = nullptr;
+	invariantsSize = nullptr;
+	conditionalAddLists = nullptr;
+	conditionalDelLists = nullptr;
+	conditionalAddListsCondition = nullptr;
+	conditionalDelListsCondition = nullptr;
+	numConditionalAdds = nullptr;
+	numConditionalDels = nullptr;
+	numConditionalAddsConditions = nullptr;
+	numConditionalDelsConditions = nullptr;
 #if (STATEREP == SRCALC1) || (STATEREP == SRCALC2)
 	addVectors = nullptr;
 	delVectors = nullptr;
@@ -96,30 +113,40 @@ Model::Model() {
 }
 
 Model::~Model() {
+	releaseCacheMapping();
+	delete nameIndex;
 	delete[] factStrs;
 	delete[] firstIndex;
 	delete[] lastIndex;
 	delete[] varNames;
+	delete[] strictMutexes;
+	delete[] strictMutexesSize;
+	delete[] mutexes;
+	delete[] mutexesSize;
+	delete[] invariants;
+	delete[] invariantsSize;
 	delete[] actionCosts;
-	for (int i = 0; i < numActions; i++) {
-		delete[] precLists[i];
-		delete[] addLists[i];
-		delete[] delLists[i];
-	}
 	delete[] precLists;
 	delete[] addLists;
 	delete[] delLists;
 	delete[] precLessActions;
 	delete[] precToActionSize;
-	for (int i = 0; i < numStateBits; i++) {
-		delete[] precToAction[i];
-	}
 	delete[] precToAction;
 	delete[] numPrecs;
 	delete[] numAdds;
 	delete[] numDels;
-	delete[] s0List;
-	delete[] gList;
+	for (int i = 0; (conditionalAddListsCondition != nullptr) && (i < numActions); i++) {
+		delete[] conditionalAddListsCondition[i];
+		delete[] conditionalDelListsCondition[i];
+	}
+	delete[] conditionalAddListsCondition;
+	delete[] conditionalDelListsCondition;
+	delete[] conditionalAddLists;
+	delete[] conditionalDelLists;
+	delete[] numConditionalAddsConditions;
+	delete[] numConditionalDelsConditions;
+	delete[] numConditionalAdds;
+	delete[] numConditionalDels;
 	delete[] isPrimitive;
 	delete[] taskNames;
 #if (STATEREP == SRCALC1) || (STATEREP == SRCALC2)
@@ -142,23 +169,12 @@ Model::~Model() {
 	delete[] methodNames;
 	delete[] numFirstTasks;
 	delete[] numLastTasks;
-	for (int i = 0; i < numTasks; i++) {
-		delete[] taskToMethods[i];
-	}
 	delete[] taskToMethods;
 	delete[] numMethodsForTask;
-	for (int i = 0; i < numMethods; i++) {
-		delete[] subTasks[i];
-		delete[] ordering[i];
-		delete[] methodsFirstTasks[i];
-		delete[] methodsLastTasks[i];
-	}
 	delete[] subTasks;
 	delete[] ordering;
 	delete[] methodsFirstTasks;
 	delete[] methodsLastTasks;
-	for (int i = 0; i < numMethods; i++)
-		delete[] methodSubtaskSuccNum[i];
 	delete[] methodSubtaskSuccNum;
 	if (calculatedSccs) {
 		delete[] sccGnumSucc;
@@ -194,17 +210,11 @@ Model::~Model() {
 #endif
 
 	delete[] numDistinctSTs;
-	for(int i = 0; i < numMethods; i++) {
-		delete[] sortedDistinctSubtasks[i];
-		delete[] sortedDistinctSubtaskCount[i];
-	}
 	delete[] sortedDistinctSubtasks;
 	delete[] sortedDistinctSubtaskCount;
-	for (int i =0; i < numTasks; i++){
-		delete[] stToMethod[i];
-	}
 	delete[] stToMethodNum;
 	delete[] stToMethod;
+	delete[] methodDisabled;
 
 #ifdef CALCMINIMALIMPLIEDCOSTS
 	delete[] minImpliedCosts;
@@ -604,14 +614,14 @@ searchNode* Model::decompose(searchNode *n, int taskNo, int method) {
 	// prepare data structures
 	result->numPrimitive = n->numPrimitive + numFirstPrimSubTasks[method];
 	if (result->numPrimitive > 0) {
-		result->unconstraintPrimitive = new planStep*[result->numPrimitive];
+		result->unconstraintPrimitive = NodePool::local().allocArray<planStep*>(result->numPrimitive);
 	} else {
 		result->unconstraintPrimitive = nullptr;
 	}
 
 	result->numAbstract = n->numAbstract + numFirstAbstractSubTasks[method] - 1; // subtract the decomposed one
 	if (result->numAbstract > 0) {
-		result->unconstraintAbstract = new planStep*[result->numAbstract];
+		result->unconstraintAbstract = NodePool::local().allocArray<planStep*>(result->numAbstract);
 	} else {
 		result->unconstraintAbstract = nullptr;
 	}
@@ -645,7 +655,7 @@ searchNode* Model::decompose(searchNode *n, int taskNo, int method) {
 			); // returns first and last tasks
 	for (int i = 0; i < numLastTasks[method]; i++) {
 		mInstance.second[i]->successorList =
-				new planStep*[decomposed->numSuccessors];
+				NodePool::local().allocArray<planStep*>(decomposed->numSuccessors);
 		mInstance.second[i]->numSuccessors = decomposed->numSuccessors;
 		for (int j = 0; j < decomposed->numSuccessors; j++) {
 			mInstance.second[i]->successorList[j] =
@@ -682,8 +692,8 @@ searchNode* Model::decompose(searchNode *n, int taskNo, int method) {
 			absI++;
 		}
 	}
-	delete[] mInstance.first;
-	delete[] mInstance.second;
+	NodePool::local().freeArray(mInstance.first, numFirstTasks[method]);
+	NodePool::local().freeArray(mInstance.second, numLastTasks[method]);
 
 	assert(primI == result->numPrimitive);
 	assert(absI == result->numAbstract);
@@ -942,7 +952,8 @@ pair<planStep**, planStep**> Model::initializeMethod(int method
 		, int parentSolutionStepIndex
 #endif
 		) {
-	planStep** stepPointerList = new planStep*[numSubTasks[method]];
+	NodePool& pool = NodePool::local();
+	planStep** stepPointerList = pool.allocArray<planStep*>(numSubTasks[method]);
 	for (int i = 0; i < numSubTasks[method]; i++) {
 		stepPointerList[i] = new planStep;
 		stepPointerList[i]->id = ++this->psID;
@@ -957,7 +968,7 @@ pair<planStep**, planStep**> Model::initializeMethod(int method
 		stepPointerList[i]->numSuccessors = 0;
 		if (methodSubtaskSuccNum[method][i] > 0) {
 			stepPointerList[i]->successorList =
-					new planStep*[methodSubtaskSuccNum[method][i]];
+					pool.allocArray<planStep*>(methodSubtaskSuccNum[method][i]);
 		}
 	}
 	for (int i = 0; i < numOrderings[method]; i += 2) {
@@ -968,15 +979,15 @@ pair<planStep**, planStep**> Model::initializeMethod(int method
 		stepPointerList[succ]->pointersToMe++;
 	}
 
-	planStep** firsts = new planStep*[numFirstTasks[method]];
-	planStep** lasts = new planStep*[numLastTasks[method]];
+	planStep** firsts = pool.allocArray<planStep*>(numFirstTasks[method]);
+	planStep** lasts = pool.allocArray<planStep*>(numLastTasks[method]);
 	for (int i = 0; i < numFirstTasks[method]; i++) {
 		firsts[i] = stepPointerList[methodsFirstTasks[method][i]];
 	}
 	for (int i = 0; i < numLastTasks[method]; i++) {
 		lasts[i] = stepPointerList[methodsLastTasks[method][i]];
 	}
-	delete[] stepPointerList;
+	pool.freeArray(stepPointerList, numSubTasks[method]);
 	return make_pair(firsts, lasts);
 }
 
@@ -1098,8 +1109,8 @@ searchNode* Model::apply(searchNode* n, int taskNo) {
 			result->numAbstract++;
 		}
 	}
-	result->unconstraintAbstract = new planStep*[result->numAbstract];
-	result->unconstraintPrimitive = new planStep*[result->numPrimitive];
+	result->unconstraintAbstract = NodePool::local().allocArray<planStep*>(result->numAbstract);
+	result->unconstraintPrimitive = NodePool::local().allocArray<planStep*>(result->numPrimitive);
 #ifdef ONEMODMETH
 	oneMod->clear();
 #endif
@@ -1554,15 +1565,14 @@ void Model::generateMethodRepresentation() {
 		tTaskToMethods[decomposedTask[i]].push_back(i);
 	}
 
-	taskToMethods = new int*[numTasks];
 	numMethodsForTask = new int[numTasks];
-	for (int i = 0; i < numTasks; i++) {
+	for (int i = 0; i < numTasks; i++)
 		numMethodsForTask[i] = tTaskToMethods[i].size();
+	taskToMethods = arena.allocRows(numTasks, numMethodsForTask);
+	for (int i = 0; i < numTasks; i++) {
 		if (numMethodsForTask[i] > 0) {
 			assert(!isPrimitive[i]);
-			taskToMethods[i] = new int[numMethodsForTask[i]];
 		} else {
-			taskToMethods[i] = nullptr;
 			if (!isPrimitive[i]) {
 				cout << "Warning: The task " << taskNames[i]
 						<< " is abstract but there is no method to decompose it."
@@ -1582,12 +1592,11 @@ void Model::generateMethodRepresentation() {
 	numFirstPrimSubTasks = new int[numMethods];
 	methodsLastTasks = new int*[numMethods];
 	numLastTasks = new int[numMethods];
-	methodSubtaskSuccNum = new int*[numMethods];
+	methodSubtaskSuccNum = arena.allocRows(numMethods, numSubTasks);
 
 	for (int i = 0; i < numMethods; i++) {
 		bool firsts[numSubTasks[i]];
 		bool lasts[numSubTasks[i]];
-		methodSubtaskSuccNum[i] = new int[numSubTasks[i]];
 		for (int j = 0; j < numSubTasks[i]; j++) {
 			methodSubtaskSuccNum[i][j] = 0;
 		}
@@ -1618,8 +1627,8 @@ void Model::generateMethodRepresentation() {
 			if (lasts[j])
 				numLastTasks[i]++;
 		}
-		methodsFirstTasks[i] = new int[numFirstTasks[i]];
-		methodsLastTasks[i] = new int[numLastTasks[i]];
+		methodsFirstTasks[i] = arena.alloc(numFirstTasks[i]);
+		methodsLastTasks[i] = arena.alloc(numLastTasks[i]);
 		int curFI = 0;
 		int curLI = 0;
 		for (int j = 0; j < numSubTasks[i]; j++) {
@@ -1633,41 +1642,185 @@ void Model::generateMethodRepresentation() {
 	}
 }
 
-void Model::readClassical(istream& domainFile) {
-	string line;
-	getline(domainFile, line);
-	stringstream* sStream;
-	sStream = new stringstream(line);
+// Model::read parses the blocks of actions and methods in chunks on up to
+// readThreads threads, each chunk into a local buffer (see scanIntList).
+// The buffers are copied into the arena in input order afterwards, so the
+// model does not depend on the number of threads.
+int Model::readThreads = 0;
+
+// number of chunks for n items, at least minItems items per chunk
+static int numReadChunks(int n, int minItems) {
+	int threads = (Model::readThreads > 0) ? Model::readThreads : (int) thread::hardware_concurrency();
+	return max(1, min(max(threads, 1), n / minItems));
+}
+
+// body(chunk, first, last) on consecutive ranges of [0, n), chunk 0 on the calling thread
+static void forEachChunk(int n, int numChunks, const function<void(int, int, int)>& body) {
+	vector<thread> threads;
+	for (int c = 1; c < numChunks; c++)
+		threads.emplace_back(body, c, (int) ((long long) n * c / numChunks),
+				(int) ((long long) n * (c + 1) / numChunks));
+	body(0, 0, (int) ((long long) n / numChunks));
+	for (thread& t : threads)
+		t.join();
+}
+
+// start of each of the next n items of linesPerItem lines, starts[n] is the
+// end of the block; returns the number of complete items
+static int itemStarts(LineScanner& in, int n, int linesPerItem, vector<const char*>& starts) {
+	starts.resize(n + 1);
+	const char* line;
+	const char* lineEnd;
+	for (int i = 0; i < n; i++) {
+		starts[i] = in.position();
+		for (int l = 0; l < linesPerItem; l++) {
+			if (!in.next(line, lineEnd)) {
+				starts.resize(i + 1);
+				return i;
+			}
+		}
+	}
+	starts[n] = in.position();
+	return n;
+}
+
+// appends an int list (ended by -1, -i-2 stands for -i-1) as count, values
+static void scanIntList(const char* p, const char* end, vector<int>& out) {
+	size_t countPos = out.size();
+	out.push_back(0);
+	int x;
+	while (scanInt(p, end, x) && (x != -1)) {
+		if (x < 0) x++; // convert back to -i-1 instead of -i-2
+		out.push_back(x);
+	}
+	out[countPos] = out.size() - countPos - 1;
+}
+
+// appends a list of (number of conditions, conditions, element) ended by a
+// negative number as: count, the elements without condition, count, then
+// element, number of conditions, conditions of every conditional one
+static void scanConditionalIntList(const char* p, const char* end, vector<int>& out, vector<int>& plain,
+		vector<int>& conditional) {
+	plain.clear();
+	conditional.clear();
+	int numConditional = 0;
+	int x;
+	while (scanInt(p, end, x) && (x >= 0)) {
+		size_t pos = conditional.size();
+		conditional.push_back(0);
+		conditional.push_back(x);
+		for (int i = 0; i < x; i++) {
+			int y;
+			scanInt(p, end, y);
+			conditional.push_back(y);
+		}
+		int element;
+		scanInt(p, end, element);
+		if (x == 0) {
+			conditional.resize(pos);
+			plain.push_back(element);
+		} else {
+			conditional[pos] = element;
+			numConditional++;
+		}
+	}
+	out.push_back(plain.size());
+	out.insert(out.end(), plain.begin(), plain.end());
+	out.push_back(numConditional);
+	out.insert(out.end(), conditional.begin(), conditional.end());
+}
+
+// the actions (ascending ids) whose lines start at starts[action]
+void Model::readActions(const vector<const char*>& starts, const vector<int>& actions) {
+	int n = actions.size();
+	int numChunks = numReadChunks(n, 4096);
+	vector<vector<int>> chunks(numChunks);
+	forEachChunk(n, numChunks, [&](int chunk, int first, int last) {
+		vector<int>& out = chunks[chunk];
+		vector<int> plain, conditional;
+		const char* line;
+		const char* lineEnd;
+		for (int k = first; k < last; k++) {
+			LineScanner lines(starts[actions[k]], starts[actions[k] + 1]);
+			lines.next(line, lineEnd);
+			int cost;
+			scanInt(line, lineEnd, cost);
+			out.push_back(cost);
+			lines.next(line, lineEnd);
+			scanIntList(line, lineEnd, out);
+			lines.next(line, lineEnd);
+			scanConditionalIntList(line, lineEnd, out, plain, conditional);
+			lines.next(line, lineEnd);
+			scanConditionalIntList(line, lineEnd, out, plain, conditional);
+		}
+	});
+
+	for (int c = 0; c < numChunks; c++) {
+		const int* d = chunks[c].data();
+		int first = (int) ((long long) n * c / numChunks);
+		int last = (int) ((long long) n * (c + 1) / numChunks);
+		for (int k = first; k < last; k++) {
+			int i = actions[k];
+			actionCosts[i] = *d++;
+			precLists[i] = takeIntList(d, numPrecs[i]);
+
+			std::tuple<int*,int*,int**> adds = takeConditionalIntList(d, numAdds[i], numConditionalAdds[i], numConditionalAddsConditions[i]);
+			addLists[i] = get<0>(adds);
+			conditionalAddLists[i] = get<1>(adds);
+			conditionalAddListsCondition[i] = get<2>(adds);
+
+			std::tuple<int*,int*,int**> dels = takeConditionalIntList(d, numDels[i], numConditionalDels[i], numConditionalDelsConditions[i]);
+			delLists[i] = get<0>(dels);
+			conditionalDelLists[i] = get<1>(dels);
+			conditionalDelListsCondition[i] = get<2>(dels);
+
+#ifndef NDEBUG
+			for(int j = 0; j < numPrecs[i]; j++){
+				assert(precLists[i][j] < numStateBits);
+			}
+			for(int j = 0; j < numAdds[i]; j++){
+				assert(addLists[i][j] < numStateBits);
+			}
+			for(int j = 0; j < numDels[i]; j++){
+				assert(delLists[i][j] < numStateBits);
+			}
+#endif
+		}
+		vector<int>().swap(chunks[c]);
+	}
+}
+
+void Model::readClassical(LineScanner& in) {
 	// read state bits and their descriptions
-	*sStream >> numStateBits;
-	delete sStream;
+	numStateBits = in.nextInt();
 	factStrs = new string[numStateBits];
-	for (int i = 0; i < numStateBits; i++) {
-		getline(domainFile, line);
-		factStrs[i] = line;
+	vector<const char*> factStarts;
+	if (selection == nullptr) {
+		for (int i = 0; i < numStateBits; i++) {
+			factStrs[i] = in.nextLine();
+		}
+	} else {
+		// only the facts of the selected actions are kept, see below
+		itemStarts(in, numStateBits, 1, factStarts);
+		factStarts.resize(numStateBits + 1, in.position());
 	}
-	getline(domainFile, line);
-	getline(domainFile, line);
+	in.skip(2);
 	// variable definitions
-	getline(domainFile, line);
-	sStream = new stringstream(line);
-	*sStream >> numVars;
-	delete sStream;
+	numVars = in.nextInt();
 	firstIndex = new int[numVars];
 	lastIndex = new int[numVars];
 	varNames = new string[numVars];
+	const char* line;
+	const char* lineEnd;
 	for (int i = 0; i < numVars; i++) {
-		getline(domainFile, line);
-		sStream = new stringstream(line);
-		*sStream >> firstIndex[i];
+		in.next(line, lineEnd);
+		scanInt(line, lineEnd, firstIndex[i]);
 		assert(firstIndex[i] < numStateBits);
-		*sStream >> lastIndex[i];
+		scanInt(line, lineEnd, lastIndex[i]);
 		assert(lastIndex[i] < numStateBits);
-		*sStream >> varNames[i];
-		delete sStream;
+		varNames[i] = scanToken(line, lineEnd);
 	}
-	getline(domainFile, line);
-	getline(domainFile, line);
+	in.skip(2);
 
 	for (int informationType = 0; informationType < 3; informationType++){
 		int & num = (informationType == 0) ? numStrictMutexes : ((informationType == 1) ? numMutexes : numInvariants);
@@ -1675,26 +1828,18 @@ void Model::readClassical(istream& domainFile) {
 		int** & elems = (informationType == 0) ? strictMutexes : ((informationType == 1) ? mutexes : invariants);
 
 		// read further information
-		getline(domainFile, line);
-		sStream = new stringstream(line);
-		*sStream >> num;
-		delete sStream;
+		num = in.nextInt();
 		elems = new int*[num];
 		size = new int[num];
 		for (int i = 0; i < num; i++){
-			getline(domainFile, line);
-			elems[i] = readIntList(line, size[i]);
+			elems[i] = readIntList(in, size[i]);
 		}
-		getline(domainFile, line);
-		getline(domainFile, line);
+		in.skip(2);
 	}
 
 
 	// read actions
-	getline(domainFile, line);
-	sStream = new stringstream(line);
-	*sStream >> numActions;
-	delete sStream;
+	numActions = in.nextInt();
 	actionCosts = new int[numActions];
 	
 	numPrecs = new int[numActions];
@@ -1714,44 +1859,101 @@ void Model::readClassical(istream& domainFile) {
 	conditionalAddLists = new int*[numActions];
 	conditionalAddListsCondition = new int**[numActions];
 
-	numPrecLessActions = 0;
-	for (int i = 0; i < numActions; i++) {
-		getline(domainFile, line);
-		sStream = new stringstream(line);
-		*sStream >> actionCosts[i];
-		delete sStream;
-		getline(domainFile, line);
-		precLists[i] = readIntList(line, numPrecs[i]);
-		if (numPrecs[i] == 0) {
-			numPrecLessActions++;
+	// every action is a cost, a precondition, an add and a delete line
+	vector<const char*> actionStarts;
+	itemStarts(in, numActions, 4, actionStarts);
+	actionStarts.resize(numActions + 1, in.position());
+	if (selection == nullptr) {
+		vector<int> all(numActions);
+		for (int i = 0; i < numActions; i++)
+			all[i] = i;
+		readActions(actionStarts, all);
+	} else {
+		// the selected ones are read when the task names are known
+		for (int i = 0; i < numActions; i++) {
+			actionCosts[i] = 0;
+			numPrecs[i] = numAdds[i] = numDels[i] = 0;
+			numConditionalAdds[i] = numConditionalDels[i] = 0;
+			precLists[i] = addLists[i] = delLists[i] = nullptr;
+			conditionalAddLists[i] = conditionalDelLists[i] = nullptr;
+			numConditionalAddsConditions[i] = numConditionalDelsConditions[i] = nullptr;
+			conditionalAddListsCondition[i] = conditionalDelListsCondition[i] = nullptr;
 		}
+	}
 
-		getline(domainFile, line);
-		std::tuple<int*,int*,int**> adds = readConditionalIntList(line, numAdds[i], numConditionalAdds[i], numConditionalAddsConditions[i]);
-		addLists[i] = get<0>(adds);
-		conditionalAddLists[i] = get<1>(adds);
-		conditionalAddListsCondition[i] = get<2>(adds);
-
-
-		getline(domainFile, line);
-		std::tuple<int*,int*,int**> dels = readConditionalIntList(line, numDels[i], numConditionalDels[i], numConditionalDelsConditions[i]);
-		delLists[i] = get<0>(dels);
-		conditionalDelLists[i] = get<1>(dels);
-		conditionalDelListsCondition[i] = get<2>(dels);
-
+	// s0
+	in.skip(2);
+	s0List = readIntList(in, s0Size);
+	// goal
+	in.skip(2);
+	gList = readIntList(in, gSize);
 #ifndef NDEBUG
-		for(int j = 0; j < numPrecs[i]; j++){
-			assert(precLists[i][j] < numStateBits);
-		}
-		for(int j = 0; j < numAdds[i]; j++){
-			assert(addLists[i][j] < numStateBits);
+		for(int j = 0; j < s0Size; j++){
+			assert(s0List[j] < numStateBits);
 		}
-		for(int j = 0; j < numDels[i]; j++){
-			assert(delLists[i][j] < numStateBits);
+		for(int j = 0; j < gSize; j++){
+			assert(gList[j] < numStateBits);
 		}
 #endif
+
+	// task/action names
+	in.skip(2);
+	isHtnModel = true;
+	numTasks = in.nextInt();
+	taskNames = new string[numTasks];
+	isPrimitive = new bool[numTasks];
+	vector<int> selectedActions;
+	int isAbstract;
+	for (int i = 0; i < numTasks; i++) {
+		in.next(line, lineEnd);
+		if (line == lineEnd){
+			cout << "Input promised " << numTasks << " tasks, but the list ended after " << i << endl;
+			exit(-1);
+		}
+		scanInt(line, lineEnd, isAbstract);
+		isPrimitive[i] = !isAbstract;
+		taskNames[i] = scanToken(line, lineEnd);
+		if ((selection != nullptr) && !selection->tasks.count(NameIndex::lowerCase(taskNames[i]))) {
+			taskNames[i].clear();
+		} else if ((selection != nullptr) && (i < numActions)) {
+			selectedActions.push_back(i);
+		}
+	}
+
+	if (selection != nullptr) {
+		readActions(actionStarts, selectedActions);
+		vector<bool> used(numStateBits, false);
+		auto useAll = [&](const int* list, int size) {
+			for (int j = 0; j < size; j++)
+				used[list[j]] = true;
+		};
+		for (int i : selectedActions) {
+			useAll(precLists[i], numPrecs[i]);
+			useAll(addLists[i], numAdds[i]);
+			useAll(delLists[i], numDels[i]);
+			useAll(conditionalAddLists[i], numConditionalAdds[i]);
+			useAll(conditionalDelLists[i], numConditionalDels[i]);
+			for (int j = 0; j < numConditionalAdds[i]; j++)
+				useAll(conditionalAddListsCondition[i][j], numConditionalAddsConditions[i][j]);
+			for (int j = 0; j < numConditionalDels[i]; j++)
+				useAll(conditionalDelListsCondition[i][j], numConditionalDelsConditions[i][j]);
+		}
+		useAll(s0List, s0Size);
+		useAll(gList, gSize);
+		for (int f = 0; f < numStateBits; f++) {
+			if (used[f]) {
+				LineScanner fact(factStarts[f], factStarts[f + 1]);
+				factStrs[f] = fact.nextLine();
+			}
+		}
 	}
 
+	numPrecLessActions = 0;
+	for (int i = 0; i < numActions; i++) {
+		if (numPrecs[i] == 0) {
+			numPrecLessActions++;
+		}
+	}
 	// determine set of actions that have no precondition
 	if (numPrecLessActions > 0) {
 		int cur = 0;
@@ -1782,9 +1984,7 @@ void Model::readClassical(istream& domainFile) {
 			for (int j = 0; j < numPrecs[i]; j++) cout << " " << precLists[i][j];
 			cout << endl;
 #endif
-			numPrecs[i] = intSet.size();
-			delete[] precLists[i];
-			precLists[i] = new int[numPrecs[i]];
+			numPrecs[i] = intSet.size(); // fits into the old row
 			int cur = 0;
 			for (int p : intSet) {
 				precLists[i][cur++] = p;
@@ -1801,203 +2001,171 @@ void Model::readClassical(istream& domainFile) {
 		}
 	}
 	precToActionSize = new int[numStateBits];
-	precToAction = new int*[numStateBits];
+	for (int i = 0; i < numStateBits; i++)
+		precToActionSize[i] = precToActionTemp[i].size();
+	precToAction = arena.allocRows(numStateBits, precToActionSize);
 
 	for (int i = 0; i < numStateBits; i++) {
-		precToActionSize[i] = precToActionTemp[i].size();
-		precToAction[i] = new int[precToActionSize[i]];
 		int cur = 0;
 		for (int ac : precToActionTemp[i]) {
 			precToAction[i][cur++] = ac;
 		}
 	}
-	// s0
-	getline(domainFile, line);
-	getline(domainFile, line);
-	getline(domainFile, line);
-	s0List = readIntList(line, s0Size);
-	// goal
-	getline(domainFile, line);
-	getline(domainFile, line);
-	getline(domainFile, line);
-	gList = readIntList(line, gSize);
-#ifndef NDEBUG
-		for(int j = 0; j < s0Size; j++){
-			assert(s0List[j] < numStateBits);
-		}
-		for(int j = 0; j < gSize; j++){
-			assert(gList[j] < numStateBits);
-		}
-#endif
-
-	// task/action names
-	getline(domainFile, line);
-	getline(domainFile, line);
-	getline(domainFile, line);
-	isHtnModel = true;
-	sStream = new stringstream(line);
-	*sStream >> numTasks;
-	delete sStream;
-	taskNames = new string[numTasks];
-	isPrimitive = new bool[numTasks];
-	bool isAbstract;
-	for (int i = 0; i < numTasks; i++) {
-		getline(domainFile, line);
-		if (line.size() == 0){
-			cout << "Input promised " << numTasks << " tasks, but the list ended after " << i << endl;
-			exit(-1);
-		}
-		sStream = new stringstream(line);
-		*sStream >> isAbstract;
-		isPrimitive[i] = !isAbstract;
-		*sStream >> taskNames[i];
-		delete sStream;
-	}
 }
 
-void Model::readHierarchical(istream& domainFile) {
-	stringstream* sStream;
-	string line;
+void Model::readHierarchical(LineScanner& in) {
+	const char* line;
+	const char* lineEnd;
 	// tasks
 	for (int i = 0; i < 3; i++) {
-		getline(domainFile, line);
-		if (!i && line.size()){
-			cout << "Excess task (list of tasks is longer than expected)" << endl;
-			exit(-1);
-		}
-		if (domainFile.eof()) {
+		if (!in.next(line, lineEnd)) {
 			isHtnModel = false;
 			return;
 		}
+		if (!i && (line != lineEnd)){
+			cout << "Excess task (list of tasks is longer than expected)" << endl;
+			exit(-1);
+		}
 	}
 	isHtnModel = true;
-	sStream = new stringstream(line);
-	*sStream >> initialTask;
-	delete sStream;
+	scanInt(line, lineEnd, initialTask);
 	assert(initialTask < numTasks);
 	// methods
-	getline(domainFile, line);
-	getline(domainFile, line);
-	getline(domainFile, line);
-	sStream = new stringstream(line);
-	*sStream >> numMethods;
-	delete sStream;
+	in.skip(2);
+	numMethods = in.nextInt();
 	decomposedTask = new int[numMethods];
 	subTasks = new int*[numMethods];
 	numSubTasks = new int[numMethods];
 	ordering = new int*[numMethods];
 	numOrderings = new int[numMethods];
 	methodNames = new string[numMethods];
-	for (int i = 0; i < numMethods; i++) {
-		getline(domainFile, line);
-		if (domainFile.eof()){
-			cout << "Input promised " << numMethods << " methods, but input ended after " << i << endl;
-			exit(-1);
-		}
-		methodNames[i] = line;
-		getline(domainFile, line);
-		sStream = new stringstream(line);
-		*sStream >> decomposedTask[i];
-		assert(decomposedTask[i] < numTasks);
-		delete sStream;
-		getline(domainFile, line);
-		subTasks[i] = readIntList(line, numSubTasks[i]);
 
-		/*
-		if (numSubTasks[i] == 0) {
-			cout << "Search engine: Method " << methodNames[i]
-					<< " has no subtasks - please compile this away before search."
-					<< endl;
-			exit(-1);
-		}*/
+	// every method is a name, a task, a subtask and an ordering line
+	vector<const char*> starts;
+	int numRead = itemStarts(in, numMethods, 4, starts);
+	if (numRead < numMethods) {
+		cout << "Input promised " << numMethods << " methods, but input ended after " << numRead << endl;
+		exit(-1);
+	}
+	int numChunks = numReadChunks(numMethods, 1024);
+	vector<vector<int>> chunks(numChunks);
+	forEachChunk(numMethods, numChunks, [&](int chunk, int first, int last) {
+		// name and task go to the model directly, subtasks and the transitively
+		// reduced orderings to the buffer
+		vector<int>& out = chunks[chunk];
+		vector<int> list;
+		LineScanner lines(starts[first], starts[last]);
+		const char* line;
+		const char* lineEnd;
+		for (int i = first; i < last; i++) {
+			methodNames[i] = lines.nextLine();
+			lines.next(line, lineEnd);
+			scanInt(line, lineEnd, decomposedTask[i]);
+			if ((selection != nullptr) && !selection->methods.count(methodNames[i])) {
+				methodNames[i].clear();
+				lines.skip(2);
+				out.push_back(0);
+				out.push_back(0);
+				continue;
+			}
+			lines.next(line, lineEnd);
+			size_t subtasksPos = out.size();
+			scanIntList(line, lineEnd, out);
+			int numSub = out[subtasksPos];
+			lines.next(line, lineEnd);
+			list.clear();
+			scanIntList(line, lineEnd, list);
+			int numOrd = list[0];
+			const int* ord = list.data() + 1;
+
+			// transitive reduction (i.e. remove all unnecessary edges)
+			vector<vector<bool>> trans (numSub);
+			for (int x = 0; x < numSub; x++)
+				for (int y = 0; y < numSub; y++) trans[x].push_back(false);
+
+			for (int o = 0; o < numOrd; o+=2)
+				trans[ord[o]][ord[o+1]] = true;
+
+			for (int k = 0; k < numSub; k++)
+				for (int x = 0; x < numSub; x++)
+					for (int y = 0; y < numSub; y++)
+						if (trans[x][k] && trans[k][y]) trans[x][y] = false;
+
+			size_t orderingPos = out.size();
+			out.push_back(0);
+			for (int x = 0; x < numSub; x++)
+				for (int y = 0; y < numSub; y++)
+					if (trans[x][y])
+						out.push_back(x), out.push_back(y);
+			out[orderingPos] = out.size() - orderingPos - 1;
+		}
+	});
+
+	for (int c = 0; c < numChunks; c++) {
+		const int* d = chunks[c].data();
+		int first = (int) ((long long) numMethods * c / numChunks);
+		int last = (int) ((long long) numMethods * (c + 1) / numChunks);
+		for (int i = first; i < last; i++) {
+			assert(decomposedTask[i] < numTasks);
+			subTasks[i] = takeIntList(d, numSubTasks[i]);
+			ordering[i] = takeIntList(d, numOrderings[i]);
 #ifndef NDEBUG
-		for (int j = 0; j < numSubTasks[i]; j++) {
-			assert(subTasks[i][j] < numTasks);
-		}
+			for (int j = 0; j < numSubTasks[i]; j++) {
+				assert(subTasks[i][j] < numTasks);
+			}
 #endif
-		getline(domainFile, line);
-		ordering[i] = readIntList(line, numOrderings[i]);
-		
-		
-		//vector<vector<int>> adj (numSubTasks[i]);
-		//for (int o = 0; o < numOrderings[i]; o+=2)
-		//	adj[ordering[i][o]].push_back(ordering[i][o+1]);
-
-		// transitive reduction (i.e. remove all unnecessary edges)
-		vector<vector<bool>> trans (numSubTasks[i]);
-		for (int x = 0; x < numSubTasks[i]; x++)
-			for (int y = 0; y < numSubTasks[i]; y++) trans[x].push_back(false);
-		
-		for (int o = 0; o < numOrderings[i]; o+=2)
-			trans[ordering[i][o]][ordering[i][o+1]] = true;
-
-		for (int k = 0; k < numSubTasks[i]; k++)
-			for (int x = 0; x < numSubTasks[i]; x++)
-				for (int y = 0; y < numSubTasks[i]; y++)
-					if (trans[x][k] && trans[k][y]) trans[x][y] = false;
-
-		vector<int> ord;
-		for (int x = 0; x < numSubTasks[i]; x++)
-			for (int y = 0; y < numSubTasks[i]; y++)
-				if (trans[x][y])
-					ord.push_back(x), ord.push_back(y);
-
-		ordering[i] = new int[ord.size()];
-		for (int x = 0; x < ord.size(); x++)
-			ordering[i][x] = ord[x];
-		numOrderings[i] = ord.size();
-
-
 #ifndef NDEBUG
-		assert((numOrderings[i] % 2) == 0);
-		for (int j = 0; j < numOrderings[i]; j++) {
-			assert(ordering[i][j] < numSubTasks[i]);
-		}
-
-		// test if subtask ordering is cyclic
-		set<int> ignore;
-		bool changed = true;
-		while(changed) {
-			changed = false;
-			for(int st = 0; st < numSubTasks[i]; st++) {
-				if (ignore.find(st) != ignore.end()) continue;
-
-				bool stHasPred = false;
-				for(int o = 0; o < numOrderings[i]; o += 2) {
-					int t1 = ordering[i][o];
-					int t2 = ordering[i][o + 1];
-					if (ignore.find(t1) != ignore.end()) continue;
-					if (t2 == st) {
-						stHasPred = true;
+			assert((numOrderings[i] % 2) == 0);
+			for (int j = 0; j < numOrderings[i]; j++) {
+				assert(ordering[i][j] < numSubTasks[i]);
+			}
+
+			// test if subtask ordering is cyclic
+			set<int> ignore;
+			bool changed = true;
+			while(changed) {
+				changed = false;
+				for(int st = 0; st < numSubTasks[i]; st++) {
+					if (ignore.find(st) != ignore.end()) continue;
+
+					bool stHasPred = false;
+					for(int o = 0; o < numOrderings[i]; o += 2) {
+						int t1 = ordering[i][o];
+						int t2 = ordering[i][o + 1];
+						if (ignore.find(t1) != ignore.end()) continue;
+						if (t2 == st) {
+							stHasPred = true;
+							break;
+						}
+					}
+					if(stHasPred) continue;
+					else {
+						ignore.insert(st);
+						changed = true;
 						break;
 					}
 				}
-				if(stHasPred) continue;
-				else {
-					ignore.insert(st);
-					changed = true;
-					break;
-				}
 			}
-		}
-		if(ignore.size() < numSubTasks[i]) {
-			cout << "Ordering relations of method " << methodNames[i] << " are cyclic.";
-			assert(ignore.size() < numSubTasks[i]);
-		}
-		for(int o = 0; o < numOrderings[i]; o += 2) {
-			int t11 = ordering[i][o];
-			int t12 = ordering[i][o + 1];
-			for(int o2 = o + 2; o2 < numOrderings[i]; o2 += 2) {
-				int t21 = ordering[i][o2];
-				int t22 = ordering[i][o2 + 1];
-
-				if((t11 == t21) && (t12 == t22)){
-					cout << "Ordering relations of method " << methodNames[i] << " are redundant." << endl;
-					assert(false);
+			if(ignore.size() < numSubTasks[i]) {
+				cout << "Ordering relations of method " << methodNames[i] << " are cyclic.";
+				assert(ignore.size() < numSubTasks[i]);
+			}
+			for(int o = 0; o < numOrderings[i]; o += 2) {
+				int t11 = ordering[i][o];
+				int t12 = ordering[i][o + 1];
+				for(int o2 = o + 2; o2 < numOrderings[i]; o2 += 2) {
+					int t21 = ordering[i][o2];
+					int t22 = ordering[i][o2 + 1];
+
+					if((t11 == t21) && (t12 == t22)){
+						cout << "Ordering relations of method " << methodNames[i] << " are redundant." << endl;
+						assert(false);
+					}
 				}
 			}
-		}
 #endif
+		}
+		vector<int>().swap(chunks[c]);
 	}
 
 	// Mapping from task to methods where it is a subtasks
@@ -2011,10 +2179,9 @@ void Model::readHierarchical(istream& domainFile) {
 		}
 	}
 
-	stToMethod = new int*[this->numTasks];
+	stToMethod = arena.allocRows(this->numTasks, stToMethodNum);
 	int k[this->numTasks];
 	for (int i = 0; i < this->numTasks; i++) {
-		stToMethod[i] = new int[stToMethodNum[i]];
 		k[i] = 0;
 	}
 
@@ -2072,8 +2239,8 @@ void Model::readHierarchical(istream& domainFile) {
 
 	for(int m =0;  m < this->numMethods; m++) {
 		int n = this->numSubTasks[m];
-		int* sts = new int[n];
-		int* stcount = new int[n];
+		int* sts = arena.alloc(n);
+		int* stcount = arena.alloc(n);
 
 		for(int ist = 0; ist < n; ist++) {
 			sts[ist] = this->subTasks[m][ist];
@@ -2134,26 +2301,40 @@ void Model::generateVectorRepresentation() {
 }
 #endif
 
+void Model::readSelected(string f, const ModelSelection& selection) {
+	this->selection = &selection;
+	read(f);
+	this->selection = nullptr;
+	isPartial = true;
+}
+
 void Model::read(string f) {
-	const char *cstr = f.c_str();
-	
-	std::istream * inputStream;
+	// the whole file is parsed from memory, see readClassical and readHierarchical
+	string text;
 	if (f == "stdin"){
-		inputStream = &std::cin;
+		stringstream buffer;
+		buffer << std::cin.rdbuf();
+		text = buffer.str();
 	} else {
-		ifstream * fileInput  = new ifstream(f);
-		if (!fileInput->good()) {
+		ifstream fileInput(f, ios::binary);
+		if (!fileInput.good()) {
 			std::cerr << "Unable to open input file " << f << ": " << strerror (errno) << std::endl;
 			exit(1);
 		}
-
-		inputStream = fileInput;
+		fileInput.seekg(0, ios::end);
+		text.resize(fileInput.tellg());
+		fileInput.seekg(0, ios::beg);
+		fileInput.read(&text[0], text.size());
 	}
-	
-	string line;
-	getline(*inputStream, line);
-	readClassical(*inputStream);
-	readHierarchical(*inputStream);
+
+	LineScanner in(text.data(), text.data() + text.size());
+	in.skip(1);
+	readClassical(in);
+	readHierarchical(in);
+	finishReading();
+}
+
+void Model::finishReading() {
 	printSummary();
 	if (isHtnModel) {
 		generateMethodRepresentation();
@@ -2161,10 +2342,6 @@ void Model::read(string f) {
 #if (STATEREP == SRCALC1) || (STATEREP == SRCALC2)
 	generateVectorRepresentation();
 #endif
-	if (f != "stdin"){
-		((ifstream*) inputStream)->close();
-	}
-    delete inputStream;
 // for debug:
 #if DLEVEL == 5
 	printActions();
@@ -2172,75 +2349,147 @@ void Model::read(string f) {
 #endif
 }
 
-tuple<int*,int*,int**> Model::readConditionalIntList(string s, int& sizeA, int& sizeB, int*& sizeC){
-	stringstream sStream(s);
-	vector<int> v;
-	vector<pair<vector<int>,int>> conds;
-	int x;
-	sStream >> x;
-	while (x >= 0) {
-		vector<int> c;
-		for (int i = 0; i < x; i++){
-			int y; sStream >> y;
-			c.push_back(y);
-		}
-
-		// read the actual unguarded element
-		sStream >> x;
-
-		if (!c.size())
-			v.push_back(x);
-		else
-			conds.push_back(make_pair(c,x));
-
-		// read the beginning of the next
-		sStream >> x;
-	}
-	sizeA = v.size();
-	sizeB = conds.size();
+// a list written by scanConditionalIntList, with the rows allocated in the
+// same order as they were when the lines were read one by one
+tuple<int*,int*,int**> Model::takeConditionalIntList(const int*& d, int& sizeA, int& sizeB, int*& sizeC){
+	sizeA = *d++;
+	const int* v = d;
+	d += sizeA;
+	sizeB = *d++;
+	sizeC = nullptr;
 
 	int* A = nullptr;
 	int* B = nullptr;
 	int** C = nullptr;
 	if (sizeA) {
-		A = new int[sizeA];
+		A = arena.alloc(sizeA);
 		for (int i = 0; i < sizeA; i++) A[i] = v[i];
 	}
 
 	if (sizeB){
-		B = new int[sizeB];
+		B = arena.alloc(sizeB);
 		C = new int*[sizeB];
+		sizeC = arena.alloc(sizeB);
 		for (int i = 0; i < sizeB; i++){
-			B[i] = conds[i].second;
-			C[i] = new int[conds[i].first.size()];
-			for (size_t j = 0; j < conds[i].first.size(); j++) C[i][j] = conds[i].first[j];
+			B[i] = *d++;
+			sizeC[i] = *d++;
+			C[i] = arena.alloc(sizeC[i]);
+			for (int j = 0; j < sizeC[i]; j++) C[i][j] = *d++;
 		}
 	}
 
 	return make_tuple(A,B,C);
 }
 
+// a list written by scanIntList
+int* Model::takeIntList(const int*& d, int& size) {
+	size = *d++;
+	int* res = nullptr;
+	if (size > 0) {
+		res = arena.alloc(size);
+		for (int i = 0; i < size; i++) {
+			res[i] = d[i];
+		}
+	}
+	d += size;
+	return res;
+}
 
-int* Model::readIntList(string s, int& size) {
-	stringstream sStream(s);
+int* Model::readIntList(LineScanner& in, int& size) {
+	const char* line;
+	const char* lineEnd;
+	in.next(line, lineEnd);
 	vector<int> v;
-	int x;
-	sStream >> x;
-	while (x != -1) {
-		if (x < 0) x++; // convert back to -i-1 instead of -i-2
-		v.push_back(x);
-		sStream >> x;
+	scanIntList(line, lineEnd, v);
+	const int* d = v.data();
+	return takeIntList(d, size);
+}
+
+// moves value behind the first size entries of row and shrinks it by one
+static void moveBehind(int* row, int& size, int value) {
+	int i = 0;
+	while ((i < size) && (row[i] != value))
+		i++;
+	if (i == size)
+		return;
+	for (; i < size - 1; i++)
+		row[i] = row[i + 1];
+	row[size - 1] = value;
+	size--;
+}
+
+bool Model::disableMethod(int m) {
+	if (methodDisabled == nullptr) {
+		methodDisabled = new bool[numMethods];
+		for (int i = 0; i < numMethods; i++)
+			methodDisabled[i] = false;
 	}
-	size = v.size();
-	if (size == 0) {
-		return nullptr;
-	} else {
-		int* res = new int[size];
-		for (int i = 0; i < size; i++) {
-			res[i] = v[i];
-		}
-		return res;
+	if (methodDisabled[m])
+		return false;
+	methodDisabled[m] = true;
+	numDisabledMethods++;
+	disabledMethodLog.push_back(m);
+
+	int t = decomposedTask[m];
+	moveBehind(taskToMethods[t], numMethodsForTask[t], m);
+	for (int i = 0; i < numDistinctSTs[m]; i++) {
+		int st = sortedDistinctSubtasks[m][i];
+		moveBehind(stToMethod[st], stToMethodNum[st], m);
+	}
+	return true;
+}
+
+int Model::disableTask(int t) {
+	int num = 0;
+	while (numMethodsForTask[t] > 0) {
+		disableMethod(taskToMethods[t][0]);
+		num++;
+	}
+	return num;
+}
+
+int Model::disableMethodsByName(const string& name) {
+	int num = 0;
+	// compressed names look like <<name;task[args];...>, plain ones like name[args]
+	for (int m : names().methodsWithComponent(name)) {
+		if (!isMethodEnabled(m))
+			continue;
+		disableMethod(m);
+		num++;
 	}
+	return num;
+}
+
+void Model::enableAllMethods() {
+	if (numDisabledMethods == 0)
+		return;
+	// disabled methods are still stored behind the rows, growing the rows back
+	// and sorting them restores the original (ascending) order
+	for (int m = 0; m < numMethods; m++) {
+		if (!methodDisabled[m])
+			continue;
+		numMethodsForTask[decomposedTask[m]]++;
+		for (int i = 0; i < numDistinctSTs[m]; i++)
+			stToMethodNum[sortedDistinctSubtasks[m][i]]++;
+	}
+	for (int m = 0; m < numMethods; m++) {
+		if (!methodDisabled[m])
+			continue;
+		int t = decomposedTask[m];
+		sort(taskToMethods[t], taskToMethods[t] + numMethodsForTask[t]);
+		for (int i = 0; i < numDistinctSTs[m]; i++) {
+			int st = sortedDistinctSubtasks[m][i];
+			sort(stToMethod[st], stToMethod[st] + stToMethodNum[st]);
+		}
+		methodDisabled[m] = false;
+	}
+	numDisabledMethods = 0;
+	disabledMethodLog.clear();
+	numMaskResets++;
+}
+
+bool Model::isMethodEnabled(int m) const {
+	return (methodDisabled == nullptr) || !methodDisabled[m];
 }
 
 void Model::printSummary() {
@@ -2691,7 +2940,7 @@ searchNode* Model::prepareTNi(const Model* htn) {
 	tnI->numPrimitive = 0;
 	tnI->unconstraintPrimitive = nullptr;
 	tnI->numAbstract = 1;
-	tnI->unconstraintAbstract = new planStep*[1];
+	tnI->unconstraintAbstract = NodePool::local().allocArray<planStep*>(1);
 	tnI->unconstraintAbstract[0] = new planStep();
 	tnI->unconstraintAbstract[0]->task = htn->initialTask;
 	tnI->unconstraintAbstract[0]->pointersToMe = 1;
@@ -9,12 +9,18 @@
 #define MODEL_H_
 
 #include <climits>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <set>
+#include <unordered_set>
 #include <forward_list>
+#include <mutex>
 
 #include "ProgressionNetwork.h"
+#include "IntArena.h"
+#include "LineScanner.h"
+#include "NameIndex.h"
 #include "../utils/noDelIntSet.h"
 #include "../utils/FlexIntStack.h"
 #include "../utils/IntUtil.h"
@@ -24,6 +30,27 @@ using namespace std;
 
 namespace progression {
 
+// the tasks (by NameIndex::lowerCase of their name) and methods of which
+// Model::readSelected() reads more than the id
+struct ModelSelection {
+	unordered_set<string> tasks;
+	unordered_set<string> methods;
+};
+
+// identifies the contents of a model file without reading it: the file
+// (device and inode, shared by hard links), its size and modification time
+struct ModelFileStamp {
+	uint64_t device = 0;
+	uint64_t inode = 0;
+	uint64_t size = 0;
+	int64_t mtimeSec = 0;
+	int64_t mtimeNsec = 0;
+
+	bool read(const string& f); // false if f cannot be stat'ed
+	uint64_t key() const; // hash of the fields
+	bool operator==(const ModelFileStamp& other) const;
+};
+
 class Model {
 private:
 	bool first = true;
@@ -31,8 +58,18 @@ private:
 	IntUtil iu;
 	StringUtil su;
 
-	int* readIntList(string s, int& size);
-	tuple<int*,int*,int**> readConditionalIntList(string s, int& sizeA, int& sizeB, int*& sizeC);
+	// rows of the int** tables that are read or derived from the input, they
+	// are freed with the model and must not be deleted one by one
+	IntArena arena;
+	// the binary cache the model was loaded from, most rows point into it
+	void* cacheMapping = nullptr;
+	size_t cacheMappingSize = 0;
+
+	// the lists are allocated in the arena, take* copy a list from the buffer
+	// of a parsed chunk at d and move d behind it
+	int* readIntList(LineScanner& in, int& size);
+	int* takeIntList(const int*& d, int& size);
+	tuple<int*,int*,int**> takeConditionalIntList(const int*& d, int& sizeA, int& sizeB, int*& sizeC);
 	void generateMethodRepresentation();
 	pair<planStep**, planStep**> initializeMethod(int method
 #ifdef TRACESOLUTION
@@ -46,12 +83,22 @@ private:
 	void printAction(int i);
 	void printMethods();
 
-    void readClassical(std::istream& domainFile);
-	void readHierarchical(std::istream& domainFile);
+	const ModelSelection* selection = nullptr; // while readSelected() runs
+	void readActions(const vector<const char*>& starts, const vector<int>& actions);
+	void readClassical(LineScanner& in);
+	void readHierarchical(LineScanner& in);
 	void generateVectorRepresentation();
+	void finishReading(); // everything read() does after reading the input
+
+	// the fields set by readClassical and readHierarchical, in cache order (ModelCache.cpp)
+	template<class Archive> void cacheFields(Archive& ar);
+	void releaseCacheMapping();
 
 	void tarjan(int v);
 
+	mutable NameIndex* nameIndex = nullptr;
+	mutable once_flag nameIndexBuilt;
+
 	set<planStep*> potentiallyFirst;
 	set<planStep*> done;
 	forward_list<planStep*> potentialPredecessors;
@@ -65,10 +112,29 @@ public:
 	Model();
 	virtual ~Model();
 	void read(string f);
+	static int readThreads; // threads read() parses actions and methods on, 0 = all cores
+	// read() of the selected parts only: the names of the selected tasks and
+	// methods, the lists of the selected actions and methods and the names of
+	// the facts they use, the rest is empty. Ids and the method counts per task
+	// are those of the full model, so plans of the selected actions can be
+	// evaluated (see likelihood/NormalizedLikelihood.h), but not searched.
+	void readSelected(string f, const ModelSelection& selection);
+
+	// read() via a binary cache. The cache is f + ".bin", or <key>.bin in
+	// cacheDir so that the hard links of a grounding (e.g. from the grounding
+	// cache) share one file. It is validated by the ModelFileStamp of f and
+	// written if missing.
+	void readCached(string f, string cacheDir = "");
+	bool writeBinary(string file, const ModelFileStamp& source);
+	bool readBinary(string file, const ModelFileStamp& source); // false if missing, stale or damaged
 	void calcSCCs();
 	searchNode* prepareTNi(const Model* htn);
 
+	// name -> id lookup, built on first use (may be called concurrently)
+	const NameIndex& names() const;
+
 	bool isHtnModel;
+	bool isPartial = false; // read by readSelected()
     string filename;
 
 	// state-bits
@@ -174,6 +240,19 @@ public:
 	int* stToMethodNum = nullptr;
 	int** stToMethod = nullptr;
 
+	// method masking: a disabled method is moved behind the used part of its
+	// rows in taskToMethods and stToMethod (the counts are decreased), so
+	// a method can be removed without parsing and grounding the model again
+	bool* methodDisabled = nullptr;
+	int numDisabledMethods = 0;
+	vector<int> disabledMethodLog; // disabled methods in the order of disableMethod(), cleared by enableAllMethods()
+	int numMaskResets = 0; // enableAllMethods() calls that enabled methods again
+	bool disableMethod(int m); // false if m was already disabled
+	int disableTask(int t); // disables all methods of t, returns their number
+	int disableMethodsByName(const string& name); // methods having name as component of their (grounded) name
+	void enableAllMethods();
+	bool isMethodEnabled(int m) const;
+
 	// transition mechanics
 	searchNode* decompose(searchNode *n, int taskNo, int method);
 	searchNode* apply(searchNode *n, int taskNo);
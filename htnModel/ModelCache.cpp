@@ -0,0 +1,420 @@
+/*
+ * ModelCache.cpp
+ *
+ * Binary cache for the data read from a .psas file. The file holds a header
+ * (magic, version, ModelFileStamp of the source, payload size) followed by the
+ * fields set in readClassical and readHierarchical: scalars, flat int arrays,
+ * jagged arrays as their concatenated rows (the row sizes are stored before
+ * them, i.e. CSR without the offsets), and string arrays as lengths plus
+ * characters. The int data starts at multiples of sizeof(int).
+ *
+ * The source is only stat'ed, not read, to validate the cache. Loading maps
+ * the file and keeps the mapping for the lifetime of the model: the rows of
+ * the jagged tables point into it (private mapping, so the method masking can
+ * still reorder them), the flat arrays and strings are copied since the model
+ * deletes them one by one. The derived representations are built by
+ * finishReading() as for the text input.
+ */
+
+#include "Model.h"
+
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace progression {
+
+static const char cacheMagic[8] = {'P', 'S', 'A', 'S', 'B', 'I', 'N', '\0'};
+static const uint32_t cacheVersion = 2;
+static atomic<int> tmpFileCounter(0);
+
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t intSize;
+	ModelFileStamp source;
+	uint64_t payloadSize;
+};
+
+// FNV-1a
+static uint64_t hashBytes(const char* data, size_t n) {
+	uint64_t hash = 14695981039346656037ULL;
+	const unsigned char* c = (const unsigned char*) data;
+	for (size_t i = 0; i < n; i++) {
+		hash ^= c[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+bool ModelFileStamp::read(const string& f) {
+	struct stat st;
+	if (stat(f.c_str(), &st) != 0)
+		return false;
+	device = st.st_dev;
+	inode = st.st_ino;
+	size = st.st_size;
+	mtimeSec = st.st_mtim.tv_sec;
+	mtimeNsec = st.st_mtim.tv_nsec;
+	return true;
+}
+
+uint64_t ModelFileStamp::key() const {
+	return hashBytes((const char*) this, sizeof(ModelFileStamp));
+}
+
+bool ModelFileStamp::operator==(const ModelFileStamp& other) const {
+	return (device == other.device) && (inode == other.inode) && (size == other.size)
+			&& (mtimeSec == other.mtimeSec) && (mtimeNsec == other.mtimeNsec);
+}
+
+class CacheWriter {
+public:
+	string buffer;
+	bool ok = true;
+
+	void put(const void* p, size_t n) {
+		buffer.append((const char*) p, n);
+	}
+	void align() {
+		buffer.append((sizeof(int) - buffer.size() % sizeof(int)) % sizeof(int), '\0');
+	}
+	void scalar(int& x) {
+		put(&x, sizeof(int));
+	}
+	void flag(bool& b) {
+		char c = b ? 1 : 0;
+		put(&c, 1);
+	}
+	void ints(int*& p, int n) {
+		align();
+		if (n > 0)
+			put(p, n * sizeof(int));
+	}
+	void row(int*& p, int n) {
+		ints(p, n);
+	}
+	void bools(bool*& p, int n) {
+		for (int i = 0; i < n; i++)
+			flag(p[i]);
+	}
+	void rows(int**& p, int numRows, int* sizes) {
+		align();
+		for (int i = 0; i < numRows; i++)
+			ints(p[i], sizes[i]);
+	}
+	void rows(int***& p, int numRows, int* numCols, int** sizes) {
+		for (int i = 0; i < numRows; i++)
+			for (int j = 0; j < numCols[i]; j++)
+				row(p[i][j], sizes[i][j]);
+	}
+	void strings(string*& p, int n) {
+		for (int i = 0; i < n; i++) {
+			int len = p[i].size();
+			scalar(len);
+		}
+		for (int i = 0; i < n; i++)
+			put(p[i].data(), p[i].size());
+	}
+};
+
+class CacheReader {
+public:
+	char* payload;
+	char* pos;
+	char* end;
+	bool ok = true;
+
+	bool take(void* p, size_t n) {
+		if (!ok || (size_t) (end - pos) < n) {
+			ok = false;
+			return false;
+		}
+		memcpy(p, pos, n);
+		pos += n;
+		return true;
+	}
+	void align() {
+		size_t pad = (sizeof(int) - (pos - payload) % sizeof(int)) % sizeof(int);
+		if ((size_t) (end - pos) < pad)
+			ok = false;
+		else
+			pos += pad;
+	}
+	// n ints in place, moves pos behind them
+	int* mapped(size_t n) {
+		if (!ok || (size_t) (end - pos) < n * sizeof(int)) {
+			ok = false;
+			return nullptr;
+		}
+		int* p = (int*) pos;
+		pos += n * sizeof(int);
+		return p;
+	}
+	void scalar(int& x) {
+		if (!take(&x, sizeof(int)) || (x < 0)) {
+			ok = false;
+			x = 0;
+		}
+	}
+	void flag(bool& b) {
+		char c = 0;
+		take(&c, 1);
+		b = (c != 0);
+	}
+	void ints(int*& p, int n) {
+		p = nullptr;
+		align();
+		if (!ok || n <= 0)
+			return;
+		if ((size_t) (end - pos) < n * sizeof(int)) {
+			ok = false;
+			return;
+		}
+		p = new int[n];
+		take(p, n * sizeof(int));
+	}
+	void row(int*& p, int n) {
+		p = nullptr;
+		align();
+		if (!ok || n <= 0)
+			return;
+		p = mapped(n);
+	}
+	void bools(bool*& p, int n) {
+		p = new bool[max(n, 0)];
+		for (int i = 0; i < n; i++)
+			flag(p[i]);
+	}
+	// the rows are stored one after the other, i.e. as the CSR block
+	void rows(int**& p, int numRows, int* sizes) {
+		p = new int*[max(numRows, 0)];
+		size_t total = 0;
+		for (int i = 0; i < numRows; i++) {
+			p[i] = nullptr;
+			if (!ok || sizes[i] < 0)
+				ok = false;
+			else
+				total += sizes[i];
+		}
+		align();
+		int* data = mapped(total);
+		if (!ok)
+			return;
+		for (int i = 0; i < numRows; i++) {
+			p[i] = (sizes[i] > 0) ? data : nullptr;
+			data += sizes[i];
+		}
+	}
+	void rows(int***& p, int numRows, int* numCols, int** sizes) {
+		p = new int**[max(numRows, 0)];
+		for (int i = 0; i < numRows; i++) {
+			p[i] = nullptr;
+			if (!ok || numCols[i] == 0)
+				continue;
+			p[i] = new int*[numCols[i]];
+			for (int j = 0; j < numCols[i]; j++)
+				row(p[i][j], ok ? sizes[i][j] : 0);
+		}
+	}
+	void strings(string*& p, int n) {
+		p = new string[max(n, 0)];
+		vector<int> lengths(max(n, 0));
+		for (int i = 0; i < n; i++)
+			scalar(lengths[i]);
+		for (int i = 0; i < n && ok; i++) {
+			if ((end - pos) < lengths[i]) {
+				ok = false;
+				return;
+			}
+			p[i].assign(pos, lengths[i]);
+			pos += lengths[i];
+		}
+	}
+};
+
+template<class Archive> void Model::cacheFields(Archive& ar) {
+	ar.scalar(numStateBits);
+	ar.strings(factStrs, numStateBits);
+	ar.scalar(numVars);
+	ar.ints(firstIndex, numVars);
+	ar.ints(lastIndex, numVars);
+	ar.strings(varNames, numVars);
+
+	ar.scalar(numStrictMutexes);
+	ar.ints(strictMutexesSize, numStrictMutexes);
+	ar.rows(strictMutexes, numStrictMutexes, strictMutexesSize);
+	ar.scalar(numMutexes);
+	ar.ints(mutexesSize, numMutexes);
+	ar.rows(mutexes, numMutexes, mutexesSize);
+	ar.scalar(numInvariants);
+	ar.ints(invariantsSize, numInvariants);
+	ar.rows(invariants, numInvariants, invariantsSize);
+	if (!ar.ok)
+		return;
+
+	ar.scalar(numActions);
+	ar.ints(actionCosts, numActions);
+	ar.ints(numPrecs, numActions);
+	ar.rows(precLists, numActions, numPrecs);
+	ar.ints(numAdds, numActions);
+	ar.rows(addLists, numActions, numAdds);
+	ar.ints(numDels, numActions);
+	ar.rows(delLists, numActions, numDels);
+	if (!ar.ok)
+		return;
+	ar.ints(numConditionalAdds, numActions);
+	ar.rows(numConditionalAddsConditions, numActions, numConditionalAdds);
+	ar.rows(conditionalAddLists, numActions, numConditionalAdds);
+	ar.rows(conditionalAddListsCondition, numActions, numConditionalAdds, numConditionalAddsConditions);
+	ar.ints(numConditionalDels, numActions);
+	ar.rows(numConditionalDelsConditions, numActions, numConditionalDels);
+	ar.rows(conditionalDelLists, numActions, numConditionalDels);
+	ar.rows(conditionalDelListsCondition, numActions, numConditionalDels, numConditionalDelsConditions);
+	ar.scalar(numPrecLessActions);
+	ar.ints(precLessActions, numPrecLessActions);
+	ar.ints(precToActionSize, numStateBits);
+	ar.rows(precToAction, numStateBits, precToActionSize);
+	if (!ar.ok)
+		return;
+
+	ar.scalar(s0Size);
+	ar.row(s0List, s0Size);
+	ar.scalar(gSize);
+	ar.row(gList, gSize);
+
+	ar.scalar(numTasks);
+	ar.strings(taskNames, numTasks);
+	ar.bools(isPrimitive, numTasks);
+	ar.flag(isHtnModel);
+	if (!ar.ok || !isHtnModel)
+		return;
+
+	ar.scalar(initialTask);
+	ar.scalar(numMethods);
+	ar.ints(decomposedTask, numMethods);
+	ar.ints(numSubTasks, numMethods);
+	ar.rows(subTasks, numMethods, numSubTasks);
+	ar.ints(numOrderings, numMethods);
+	ar.rows(ordering, numMethods, numOrderings);
+	ar.strings(methodNames, numMethods);
+	if (!ar.ok)
+		return;
+	ar.ints(stToMethodNum, numTasks);
+	ar.rows(stToMethod, numTasks, stToMethodNum);
+	ar.ints(numDistinctSTs, numMethods);
+	ar.rows(sortedDistinctSubtasks, numMethods, numDistinctSTs);
+	ar.rows(sortedDistinctSubtaskCount, numMethods, numDistinctSTs);
+}
+
+bool Model::writeBinary(string file, const ModelFileStamp& source) {
+	if (isPartial) {
+		return false; // the cache has to hold the whole model
+	}
+	CacheWriter writer;
+	cacheFields(writer);
+
+	CacheHeader header;
+	memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = cacheVersion;
+	header.intSize = sizeof(int);
+	header.source = source;
+	header.payloadSize = writer.buffer.size();
+
+	// write to a temporary file and rename it, so readers never see a partial cache
+	string tmp = file + ".tmp" + to_string(getpid()) + "." + to_string(tmpFileCounter++);
+	ofstream out(tmp, ios::binary);
+	if (!out.is_open())
+		return false;
+	out.write((const char*) &header, sizeof(header));
+	out.write(writer.buffer.data(), writer.buffer.size());
+	out.close();
+	if (!out || rename(tmp.c_str(), file.c_str()) != 0) {
+		remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool Model::readBinary(string file, const ModelFileStamp& source) {
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(CacheHeader)) {
+		close(fd);
+		return false;
+	}
+	// writable since the masking reorders rows, the changes stay in memory
+	void* data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	CacheHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion
+			|| header.intSize != sizeof(int) || !(header.source == source)
+			|| header.payloadSize != st.st_size - sizeof(CacheHeader)) {
+		munmap(data, st.st_size);
+		return false;
+	}
+
+	CacheReader reader;
+	reader.payload = (char*) data + sizeof(CacheHeader);
+	reader.pos = reader.payload;
+	reader.end = (char*) data + st.st_size;
+	cacheFields(reader);
+	bool ok = reader.ok && (reader.pos == reader.end);
+	if (!ok) {
+		// read() sets all of these fields again, the arrays read so far are only lost
+		munmap(data, st.st_size);
+		cerr << "Warning: Damaged model cache " << file << endl;
+		return false;
+	}
+	releaseCacheMapping();
+	cacheMapping = data;
+	cacheMappingSize = st.st_size;
+	return true;
+}
+
+void Model::releaseCacheMapping() {
+	if (cacheMapping != nullptr)
+		munmap(cacheMapping, cacheMappingSize);
+	cacheMapping = nullptr;
+	cacheMappingSize = 0;
+}
+
+void Model::readCached(string f, string cacheDir) {
+	ModelFileStamp source;
+	if (!source.read(f)) {
+		read(f); // reports the error
+		return;
+	}
+
+	string cacheFile;
+	if (cacheDir.empty()) {
+		cacheFile = f + ".bin";
+	} else {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) source.key());
+		cacheFile = cacheDir + ((cacheDir.back() == '/') ? "" : "/") + name;
+	}
+
+	if (readBinary(cacheFile, source)) {
+		finishReading();
+		return;
+	}
+	read(f);
+	if (!writeBinary(cacheFile, source)) {
+		cerr << "Warning: Cannot write model cache " << cacheFile << endl;
+	}
+}
+
+} /* namespace progression */
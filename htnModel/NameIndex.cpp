@@ -0,0 +1,138 @@
+/*
+ * NameIndex.cpp
+ */
+
+#include "NameIndex.h"
+#include "Model.h"
+#include "SymbolTable.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace progression {
+
+NameIndex::NameIndex(const Model* htn) : htn(htn) {
+	tasks.reserve(htn->numTasks);
+	tasksLower.reserve(htn->numTasks);
+	actionsPddl.reserve(htn->numActions);
+	for (int i = 0; i < htn->numTasks; i++) {
+		if (htn->taskNames[i].empty())
+			continue; // not read (Model::readSelected)
+		bool inserted = tasks.emplace(htn->taskNames[i], i).second;
+		if (!inserted && (i < htn->numActions))
+			duplicateActionNames = true;
+		tasksLower.emplace(lowerCase(htn->taskNames[i]), i);
+		if (i < htn->numActions)
+			actionsPddl.emplace(pddlCase(htn->taskNames[i]), i);
+	}
+	vector<int> symbols = SymbolTable::global().intern(htn->taskNames, htn->numTasks);
+	for (int i = 0; i < htn->numTasks; i++) {
+		if (symbols[i] >= (int) taskOfSymbol.size())
+			taskOfSymbol.resize(symbols[i] + 1, -1);
+		if ((taskOfSymbol[symbols[i]] < 0) && !htn->taskNames[i].empty())
+			taskOfSymbol[symbols[i]] = i;
+	}
+
+	methodsOfTask.assign(htn->numTasks, 0);
+	if (!htn->isHtnModel)
+		return;
+	methods.reserve(htn->numMethods);
+	for (int m = 0; m < htn->numMethods; m++) {
+		if (!htn->methodNames[m].empty())
+			methods[htn->methodNames[m]].push_back(m);
+		methodsOfTask[htn->decomposedTask[m]]++;
+	}
+}
+
+string NameIndex::lowerCase(const string& s) {
+	string res = s;
+	transform(res.begin(), res.end(), res.begin(), ::tolower);
+	return res;
+}
+
+string NameIndex::pddlCase(const string& s) {
+	string res = s;
+	transform(res.begin(), res.end(), res.begin(), [](unsigned char c){ if (c == '-') return int('_'); return tolower(c); });
+	return res;
+}
+
+int NameIndex::findTask(const string& name) const {
+	auto iter = tasks.find(name);
+	return (iter == tasks.end()) ? -1 : iter->second;
+}
+
+int NameIndex::findTask(int symbol) const {
+	if ((symbol < 0) || (symbol >= (int) taskOfSymbol.size()))
+		return -1;
+	return taskOfSymbol[symbol];
+}
+
+int NameIndex::findTaskIgnoreCase(const string& name) const {
+	int t = findTask(name);
+	if (t >= 0)
+		return t;
+	auto iter = tasksLower.find(lowerCase(name));
+	return (iter == tasksLower.end()) ? -1 : iter->second;
+}
+
+int NameIndex::findAction(const string& name) const {
+	int t = findTask(name);
+	return (t < htn->numActions) ? t : -1;
+}
+
+int NameIndex::findActionPddlCase(const string& name) const {
+	auto iter = actionsPddl.find(name);
+	return (iter == actionsPddl.end()) ? -1 : iter->second;
+}
+
+int NameIndex::findMethod(const string& name, int task) const {
+	auto iter = methods.find(name);
+	if (iter == methods.end())
+		return -1;
+	for (int m : iter->second) {
+		if (htn->decomposedTask[m] == task)
+			return m;
+	}
+	return -1;
+}
+
+int NameIndex::numMethods(int task) const {
+	if ((task < 0) || (task >= (int) methodsOfTask.size()))
+		return 0;
+	return methodsOfTask[task];
+}
+
+const vector<int>& NameIndex::methodsWithComponent(const string& name) const {
+	call_once(componentsBuilt, [this]() {
+		if (!htn->isHtnModel)
+			return;
+		string component;
+		for (int m = 0; m < htn->numMethods; m++) {
+			const string& s = htn->methodNames[m];
+			size_t start = 0;
+			while (start < s.size()) {
+				// up to the next ';', '<' and '>' are dropped
+				component.clear();
+				size_t end = start;
+				for (; (end < s.size()) && (s[end] != ';'); end++) {
+					if ((s[end] != '<') && (s[end] != '>'))
+						component += s[end];
+				}
+				vector<int>& ms = componentMethods[component.substr(0, component.find('['))];
+				if (ms.empty() || (ms.back() != m))
+					ms.push_back(m);
+				start = end + 1;
+			}
+		}
+	});
+	static const vector<int> none;
+	auto iter = componentMethods.find(name);
+	return (iter == componentMethods.end()) ? none : iter->second;
+}
+
+const NameIndex& Model::names() const {
+	call_once(nameIndexBuilt, [this]() { nameIndex = new NameIndex(this); });
+	return *nameIndex;
+}
+
+} /* namespace progression */
@@ -0,0 +1,62 @@
+/*
+ * NameIndex.h
+ *
+ * Hash index from task and method names to their ids, built once per model
+ * (see Model::names()). Besides the exact names it holds normalized keys:
+ * lower case for tasks, and lower case with '-' replaced by '_' for actions,
+ * since plans written by other tools may use either. If several tasks share
+ * a key, the smallest id is found, as with a linear scan.
+ *
+ * The task names are also interned in the SymbolTable, so names that were
+ * interned before (e.g. the plan of a planner log) are found by their symbol.
+ */
+
+#ifndef NAMEINDEX_H_
+#define NAMEINDEX_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+using namespace std;
+
+namespace progression {
+
+class Model;
+
+class NameIndex {
+public:
+	NameIndex(const Model* htn);
+
+	static string lowerCase(const string& s);
+	static string pddlCase(const string& s); // lower case, '-' as '_'
+
+	int findTask(const string& name) const; // -1 if unknown
+	int findTask(int symbol) const; // exact name only
+	int findTaskIgnoreCase(const string& name) const; // exact name first
+	int findAction(const string& name) const;
+	int findActionPddlCase(const string& name) const; // name has to be in pddlCase already
+	int findMethod(const string& name, int task) const; // method of task with this name, -1 if none
+	int numMethods(int task) const; // all methods of the model, disabled ones included
+	// methods with a component "name" or "name[...]", in ascending order; the
+	// components of "<<m;task[args];...>" are separated by ';' (built on first use)
+	const vector<int>& methodsWithComponent(const string& name) const;
+
+	bool duplicateActionNames = false;
+
+private:
+	const Model* htn;
+	unordered_map<string, int> tasks;
+	unordered_map<string, int> tasksLower;
+	unordered_map<string, int> actionsPddl;
+	unordered_map<string, vector<int>> methods;
+	vector<int> methodsOfTask;
+	vector<int> taskOfSymbol; // -1 if no task has the name
+	mutable unordered_map<string, vector<int>> componentMethods;
+	mutable once_flag componentsBuilt;
+};
+
+} /* namespace progression */
+
+#endif /* NAMEINDEX_H_ */
@@ -0,0 +1,138 @@
+/*
+ * NodePool.h
+ *
+ * Size-class allocator for the structures of the progression search
+ * (searchNode, planStep, solutionStep and the planStep* arrays, see
+ * ProgressionNetwork.h). Chunks of up to maxSmall bytes are cut from large
+ * blocks, a freed chunk goes to the free list of its size class and is
+ * reused by the next allocation of that size. The refcounted deletes of the
+ * search stay as they are; the blocks are only given back as a whole, by
+ * release() once a search or replay is done and none of its nodes is alive.
+ *
+ * Every thread allocates from its own pool (local()), nodes have to be freed
+ * by the thread that allocated them. setEnabled(false) sends everything to
+ * operator new / delete (e.g. for memory checkers); it must only be switched
+ * while the thread has no pooled node alive.
+ */
+
+#ifndef NODEPOOL_H_
+#define NODEPOOL_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+namespace progression {
+
+class NodePool {
+public:
+	NodePool() {
+		for (int i = 0; i < numClasses; i++)
+			freeLists[i] = nullptr;
+	}
+	~NodePool() {
+		release();
+	}
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+
+	static NodePool& local() {
+		static thread_local NodePool pool;
+		return pool;
+	}
+
+	void* alloc(size_t bytes) {
+		if (!enabled || bytes > maxSmall)
+			return ::operator new(bytes);
+		int c = sizeClass(bytes);
+		Chunk* chunk = freeLists[c];
+		if (chunk != nullptr) {
+			freeLists[c] = chunk->next;
+			return chunk;
+		}
+		size_t size = (size_t) (c + 1) * granularity;
+		if (size > left)
+			newBlock();
+		void* res = cur;
+		cur += size;
+		left -= size;
+		return res;
+	}
+
+	void free(void* p, size_t bytes) {
+		if (p == nullptr)
+			return;
+		if (!enabled || bytes > maxSmall) {
+			::operator delete(p);
+			return;
+		}
+		int c = sizeClass(bytes);
+		Chunk* chunk = static_cast<Chunk*>(p);
+		chunk->next = freeLists[c];
+		freeLists[c] = chunk;
+	}
+
+	// n elements, nullptr for n == 0 (free with the same n)
+	template<class T>
+	T* allocArray(int n) {
+		return (n > 0) ? static_cast<T*>(alloc(n * sizeof(T))) : nullptr;
+	}
+
+	template<class T>
+	void freeArray(T* p, int n) {
+		if (n > 0)
+			free(p, n * sizeof(T));
+	}
+
+	// frees all blocks, every chunk handed out so far becomes invalid
+	void release() {
+		for (char* b : blocks)
+			delete[] b;
+		blocks.clear();
+		for (int i = 0; i < numClasses; i++)
+			freeLists[i] = nullptr;
+		cur = nullptr;
+		left = 0;
+	}
+
+	void setEnabled(bool enabled) {
+		this->enabled = enabled;
+	}
+
+	size_t reservedBytes() const {
+		return blocks.size() * blockSize;
+	}
+
+private:
+	struct Chunk {
+		Chunk* next;
+	};
+
+	// alignof(max_align_t) is 16 on the usual 64 bit platforms
+	static const size_t granularity = 16;
+	static const size_t maxSmall = 512;
+	static const int numClasses = maxSmall / granularity;
+	static const size_t blockSize = 1 << 16;
+
+	Chunk* freeLists[numClasses];
+	vector<char*> blocks;
+	char* cur = nullptr;
+	size_t left = 0;
+	bool enabled = true;
+
+	static int sizeClass(size_t bytes) {
+		return (bytes == 0) ? 0 : (int) ((bytes - 1) / granularity);
+	}
+
+	void newBlock() {
+		cur = new char[blockSize];
+		left = blockSize;
+		blocks.push_back(cur);
+	}
+};
+
+} /* namespace progression */
+
+#endif /* NODEPOOL_H_ */
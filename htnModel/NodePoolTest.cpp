@@ -0,0 +1,123 @@
+/*
+ * NodePoolTest.cpp
+ *
+ * Random allocations and frees of NodePool against plain bookkeeping: live
+ * chunks are aligned, never overlap and keep their contents, a freed chunk
+ * is handed out again for its size class, and every thread has its own pool.
+ * Returns nonzero on a failed check.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include "NodePool.h"
+
+using namespace progression;
+
+namespace {
+
+struct Live {
+	unsigned char* p;
+	size_t bytes;
+	unsigned char fill;
+};
+
+atomic<int> failures(0);
+
+void check(bool ok, const char* what, int seed) {
+	if (!ok) {
+		failures++;
+		cerr << "seed " << seed << ": " << what << endl;
+	}
+}
+
+bool intact(const Live& l) {
+	for (size_t i = 0; i < l.bytes; i++)
+		if (l.p[i] != l.fill)
+			return false;
+	return true;
+}
+
+// one thread's workload on its local pool
+void exercise(int seed, bool pooled) {
+	NodePool& pool = NodePool::local();
+	pool.setEnabled(pooled);
+	mt19937 rng(seed);
+	vector<Live> live;
+	map<uintptr_t, size_t> ranges; // start -> bytes of the live chunks
+
+	for (int step = 0; step < 20000; step++) {
+		bool allocate = live.empty() || (uniform_int_distribution<int>(0, 2)(rng) > 0 && live.size() < 3000);
+		if (allocate) {
+			// mostly node sized chunks, a few larger than the size classes
+			size_t bytes = (uniform_int_distribution<int>(0, 49)(rng) == 0)
+					? uniform_int_distribution<size_t>(513, 4000)(rng)
+					: uniform_int_distribution<size_t>(1, 512)(rng);
+			Live l = { static_cast<unsigned char*>(pool.alloc(bytes)), bytes,
+					(unsigned char) uniform_int_distribution<int>(1, 255)(rng) };
+			uintptr_t start = (uintptr_t) l.p;
+			check(start % 16 == 0, "chunk is not 16 byte aligned", seed);
+			auto next = ranges.lower_bound(start);
+			bool overlaps = (next != ranges.end() && next->first < start + bytes);
+			if (next != ranges.begin()) {
+				--next;
+				overlaps = overlaps || (next->first + next->second > start);
+			}
+			check(!overlaps, "chunk overlaps a live chunk", seed);
+			ranges[start] = bytes;
+			memset(l.p, l.fill, bytes);
+			live.push_back(l);
+		} else {
+			size_t i = uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+			Live l = live[i];
+			live[i] = live.back();
+			live.pop_back();
+			check(intact(l), "contents of a live chunk changed", seed);
+			ranges.erase((uintptr_t) l.p);
+			pool.free(l.p, l.bytes);
+
+			// the next chunk of the same size class is the one just freed
+			if (pooled && l.bytes <= 512) {
+				size_t bytes = ((l.bytes - 1) / 16) * 16 + 1;
+				void* again = pool.alloc(bytes);
+				check(again == l.p, "freed chunk is not reused", seed);
+				pool.free(again, bytes);
+			}
+		}
+	}
+	for (const Live& l : live) {
+		check(intact(l), "contents of a live chunk changed", seed);
+		pool.free(l.p, l.bytes);
+	}
+
+	check(pool.allocArray<int>(0) == nullptr, "array of 0 elements is not nullptr", seed);
+	if (pooled) {
+		check(pool.reservedBytes() > 0, "pooled chunks do not come from blocks", seed);
+	} else {
+		check(pool.reservedBytes() == 0, "disabled pool reserved blocks", seed);
+	}
+	pool.release();
+	check(pool.reservedBytes() == 0, "release() kept blocks", seed);
+}
+
+} /* namespace */
+
+int main() {
+	exercise(1, true);
+	exercise(2, false);
+	exercise(3, true); // the released pool is used again
+
+	// concurrent workloads, each on the pool of its thread
+	vector<thread> threads;
+	for (int i = 0; i < 4; i++)
+		threads.emplace_back(exercise, 10 + i, true);
+	for (thread& t : threads)
+		t.join();
+
+	cout << "Node pool: " << (failures == 0 ? "all checks passed" : "checks FAILED") << endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -41,7 +41,7 @@ planStep::~planStep() {
 			delete succ;
 		}
 	}
-	delete[] successorList;
+	NodePool::local().freeArray(successorList, numSuccessors);
 #ifdef MAINTAINREACHABILITY
 	delete[] reachableT;
 #endif
@@ -89,8 +89,8 @@ searchNode::~searchNode() {
 			delete solution;
 		}
 	}
-	delete[] unconstraintAbstract;
-	delete[] unconstraintPrimitive;
+	NodePool::local().freeArray(unconstraintAbstract, numAbstract);
+	NodePool::local().freeArray(unconstraintPrimitive, numPrimitive);
 
 #ifdef TRACKTASKSINTN
 	delete[] containedTasks;
@@ -13,6 +13,7 @@
 #include <functional>
 #include <iostream>
 #include <forward_list>
+#include "NodePool.h"
 
 using namespace std;
 
@@ -34,6 +35,14 @@ struct solutionStep {
 	solutionStep* prev;
 
 	~solutionStep();
+
+	// from NodePool::local()
+	static void* operator new(size_t size) {
+		return NodePool::local().alloc(size);
+	}
+	static void operator delete(void* p, size_t size) {
+		NodePool::local().free(p, size);
+	}
 };
 
 struct planStep {
@@ -45,7 +54,7 @@ struct planStep {
 	int parentSolutionStepInstanceNumber;
 #endif
 	int numSuccessors;
-	planStep** successorList = nullptr;
+	planStep** successorList = nullptr; // NodePool array of numSuccessors
 #ifdef MAINTAINREACHABILITY
 	int numReachableT;
 	int* reachableT = nullptr;
@@ -59,6 +68,14 @@ struct planStep {
 	bool operator==(const planStep &that) const;
 
 	~planStep();
+
+	// from NodePool::local()
+	static void* operator new(size_t size) {
+		return NodePool::local().alloc(size);
+	}
+	static void operator delete(void* p, size_t size) {
+		NodePool::local().free(p, size);
+	}
 };
 
 struct searchNode {
@@ -70,7 +87,7 @@ struct searchNode {
 #endif
 	int numAbstract;
 	int numPrimitive;
-	planStep** unconstraintAbstract;
+	planStep** unconstraintAbstract; // NodePool arrays of numAbstract / numPrimitive
 	planStep** unconstraintPrimitive;
 
 	int heuristicValue;
@@ -86,6 +103,14 @@ struct searchNode {
 	~searchNode();
 	searchNode();
 
+	// from NodePool::local()
+	static void* operator new(size_t size) {
+		return NodePool::local().alloc(size);
+	}
+	static void operator delete(void* p, size_t size) {
+		NodePool::local().free(p, size);
+	}
+
 	int hRand;
 
 #ifdef TRACKTASKSINTN
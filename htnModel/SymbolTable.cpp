@@ -0,0 +1,50 @@
+/*
+ * SymbolTable.cpp
+ */
+
+#include "SymbolTable.h"
+
+namespace progression {
+
+SymbolTable& SymbolTable::global() {
+	static SymbolTable table;
+	return table;
+}
+
+int SymbolTable::intern(const string& name) {
+	lock_guard<mutex> guard(lock);
+	auto iter = ids.emplace(name, (int) names.size());
+	if (iter.second)
+		names.push_back(&iter.first->first);
+	return iter.first->second;
+}
+
+vector<int> SymbolTable::intern(const string* names, int n) {
+	lock_guard<mutex> guard(lock);
+	vector<int> symbols(n);
+	for (int i = 0; i < n; i++) {
+		auto iter = ids.emplace(names[i], (int) this->names.size());
+		if (iter.second)
+			this->names.push_back(&iter.first->first);
+		symbols[i] = iter.first->second;
+	}
+	return symbols;
+}
+
+int SymbolTable::find(const string& name) const {
+	lock_guard<mutex> guard(lock);
+	auto iter = ids.find(name);
+	return (iter == ids.end()) ? -1 : iter->second;
+}
+
+string SymbolTable::name(int symbol) const {
+	lock_guard<mutex> guard(lock);
+	return *names[symbol];
+}
+
+int SymbolTable::size() const {
+	lock_guard<mutex> guard(lock);
+	return names.size();
+}
+
+} /* namespace progression */
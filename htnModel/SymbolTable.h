@@ -0,0 +1,40 @@
+/*
+ * SymbolTable.h
+ *
+ * Process-wide interned names. A name gets the same symbol id in every model
+ * and every planner log read by the process, so plans can be passed on as
+ * symbol ids and resolved against a model without hashing their strings
+ * again (NameIndex::findTask(int)). Symbols are never removed.
+ */
+
+#ifndef SYMBOLTABLE_H_
+#define SYMBOLTABLE_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+using namespace std;
+
+namespace progression {
+
+class SymbolTable {
+public:
+	static SymbolTable& global();
+
+	int intern(const string& name); // may be called concurrently
+	vector<int> intern(const string* names, int n);
+	int find(const string& name) const; // -1 if the name was never interned
+	string name(int symbol) const;
+	int size() const;
+
+private:
+	mutable mutex lock;
+	unordered_map<string, int> ids;
+	vector<const string*> names; // keys of ids, by symbol
+};
+
+} /* namespace progression */
+
+#endif /* SYMBOLTABLE_H_ */
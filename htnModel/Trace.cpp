@@ -0,0 +1,100 @@
+/*
+ * Trace.cpp
+ */
+
+#include "Trace.h"
+
+#ifdef TRACEPIPELINE
+
+#include <fstream>
+#include <unistd.h>
+
+namespace progression {
+
+static thread_local TraceScope* innermostScope = nullptr;
+
+Trace& Trace::global() {
+	static Trace trace;
+	return trace;
+}
+
+Trace::Trace() : origin(chrono::steady_clock::now()) {
+}
+
+Trace::Buffer& Trace::local() {
+	static thread_local Buffer* buffer = nullptr;
+	if (buffer == nullptr) {
+		lock_guard<mutex> guard(lock);
+		buffers.emplace_back(new Buffer());
+		buffer = buffers.back().get();
+		buffer->thread = buffers.size();
+	}
+	return *buffer;
+}
+
+void Trace::clear() {
+	lock_guard<mutex> guard(lock);
+	for (auto& buffer : buffers)
+		buffer->events.clear();
+	origin = chrono::steady_clock::now();
+}
+
+long long Trace::now() const {
+	return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::complete(const char* name, long long start, long long end, vector<pair<const char*, long long>>& args) {
+	local().events.push_back({name, 'X', start, end - start, move(args)});
+}
+
+void Trace::counter(const char* name, long long value) {
+	local().events.push_back({name, 'C', now(), 0, {{"value", value}}});
+}
+
+bool Trace::write(const string& file) const {
+	ofstream out(file);
+	if (!out.is_open())
+		return false;
+	int pid = getpid();
+	bool first = true;
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	lock_guard<mutex> guard(lock);
+	for (const auto& buffer : buffers) {
+		for (const Event& e : buffer->events) {
+			out << (first ? "\n" : ",\n");
+			first = false;
+			// the names are literals of the instrumented code, they need no escaping
+			out << "{\"name\": \"" << e.name << "\", \"ph\": \"" << e.phase << "\", \"ts\": " << e.start;
+			if (e.phase == 'X')
+				out << ", \"dur\": " << e.duration;
+			out << ", \"pid\": " << pid << ", \"tid\": " << buffer->thread;
+			if (!e.args.empty()) {
+				out << ", \"args\": {";
+				for (size_t i = 0; i < e.args.size(); i++)
+					out << (i ? ", " : "") << "\"" << e.args[i].first << "\": " << e.args[i].second;
+				out << "}";
+			}
+			out << "}";
+		}
+	}
+	out << "\n]}" << endl;
+	return (bool) out;
+}
+
+TraceScope::TraceScope(const char* name) : name(name), start(Trace::global().now()), parent(innermostScope) {
+	innermostScope = this;
+}
+
+TraceScope::~TraceScope() {
+	innermostScope = parent;
+	Trace::global().complete(name, start, Trace::global().now(), args);
+}
+
+void TraceScope::arg(const char* key, long long value) {
+	if (innermostScope != nullptr)
+		innermostScope->args.emplace_back(key, value);
+}
+
+} /* namespace progression */
+
+#endif /* TRACEPIPELINE */
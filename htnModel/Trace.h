@@ -0,0 +1,96 @@
+/*
+ * Trace.h
+ *
+ * Scoped timers and counters of the posterior pipeline, written as a Chrome
+ * trace (chrome://tracing, ui.perfetto.dev). Compiled in with TRACEPIPELINE
+ * only; without it the macros expand to nothing and their arguments are not
+ * evaluated.
+ *
+ *   TRACE_SCOPE("name");           // event from here to the end of the block
+ *   TRACE_ARG("key", value);       // number attached to the innermost scope of the thread
+ *   TRACE_COUNTER("name", value);  // counter track
+ *
+ * Names and keys must be string literals. Every thread records into its own
+ * buffer; write() must not run while other threads still record.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#ifdef TRACEPIPELINE
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+namespace progression {
+
+class Trace {
+public:
+	static Trace& global();
+
+	// drops the events recorded so far, timestamps start again at 0
+	void clear();
+	bool write(const string& file) const;
+
+	long long now() const; // microseconds since the last clear()
+	void complete(const char* name, long long start, long long end, vector<pair<const char*, long long>>& args);
+	void counter(const char* name, long long value);
+
+private:
+	struct Event {
+		const char* name;
+		char phase; // 'X' complete, 'C' counter
+		long long start;
+		long long duration;
+		vector<pair<const char*, long long>> args;
+	};
+	struct Buffer {
+		int thread;
+		vector<Event> events;
+	};
+
+	Trace();
+	Buffer& local();
+
+	mutable mutex lock;
+	vector<unique_ptr<Buffer>> buffers; // one per thread that recorded, never freed
+	chrono::steady_clock::time_point origin;
+};
+
+class TraceScope {
+public:
+	explicit TraceScope(const char* name);
+	~TraceScope();
+
+	// to the innermost scope of the calling thread, ignored outside of a scope
+	static void arg(const char* key, long long value);
+
+private:
+	const char* name;
+	long long start;
+	vector<pair<const char*, long long>> args;
+	TraceScope* parent;
+};
+
+} /* namespace progression */
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) progression::TraceScope TRACE_JOIN(traceScope, __LINE__)(name)
+#define TRACE_ARG(key, value) progression::TraceScope::arg(key, (long long) (value))
+#define TRACE_COUNTER(name, value) progression::Trace::global().counter(name, (long long) (value))
+
+#else
+
+#define TRACE_SCOPE(name) do { } while (0)
+#define TRACE_ARG(key, value) do { (void) sizeof(value); } while (0)
+#define TRACE_COUNTER(name, value) do { (void) sizeof(value); } while (0)
+
+#endif /* TRACEPIPELINE */
+
+#endif /* TRACE_H_ */
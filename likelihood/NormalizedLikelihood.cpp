@@ -0,0 +1,919 @@
+/**
+ * Normalized likelihood for HTN goal recognition, see NormalizedLikelihood.h
+ */
+
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <cstdint>
+#include "NormalizedLikelihood.h"
+#include "../htnModel/Trace.h"
+
+// ============================================================================
+// UTILITY FUNCTIONS (from compute_full_likelihood.cpp)
+// ============================================================================
+
+// Parse plan from log
+vector<string> parsePlanFromLog(istream& file) {
+    return parsePlannerLog(file).plan;
+}
+
+vector<string> parsePlanFromLog(const string& logFile) {
+    ifstream file(logFile);
+    if (!file.is_open()) {
+        cerr << "Error: Cannot open log file: " << logFile << endl;
+        return vector<string>();
+    }
+    return parsePlanFromLog(file);
+}
+
+// Find task ID by name (exact, then lowercase)
+int findTaskId(Model* htn, const string& name) {
+    return htn->names().findTaskIgnoreCase(name);
+}
+
+// Helper to find method ID by name and decomposed task
+int findMethodId(Model* htn, const string& methodName, int taskId) {
+    return htn->names().findMethod(methodName, taskId);
+}
+
+// Check if action is applicable in state
+bool isApplicable(Model* htn, const unordered_set<int>& state, int action) {
+    for (int i = 0; i < htn->numPrecs[action]; i++) {
+        if (state.find(htn->precLists[action][i]) == state.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Apply action to state
+void applyAction(Model* htn, unordered_set<int>& state, int action) {
+    // Delete effects
+    for (int i = 0; i < htn->numDels[action]; i++) {
+        state.erase(htn->delLists[action][i]);
+    }
+    // Add effects
+    for (int i = 0; i < htn->numAdds[action]; i++) {
+        state.insert(htn->addLists[action][i]);
+    }
+}
+
+// Parse decomposition tree from planner log to get task-method pairs actually used
+map<string, int> parseDecompositionTreeFromLog(const ParsedLog& log, Model* htn, set<int>* usedMethodIds) {
+    TRACE_SCOPE("tree_parse");
+    TRACE_ARG("nodes", log.tree.size());
+    map<string, int> taskMethodCounts;
+    const NameIndex& names = htn->names();
+    
+    // decomposition lines: "ID TASK -> METHOD ..."
+    for (const LogTreeNode& node : log.tree) {
+        const string& taskName = node.task;
+        
+        // Skip abstract action markers and method preconditions
+        if (taskName.find("<abs>") == 0 || taskName.find("__method_precondition") == 0) {
+            continue;
+        }
+        
+        // Find this task in the model to get the number of alternative methods
+        int taskId = names.findTask(node.taskSymbol);
+        if (taskId < 0) {
+            taskId = names.findTaskIgnoreCase(taskName);
+        }
+        if (taskId >= 0) {
+            int numMethods = names.numMethods(taskId);
+            // Only count compound tasks (that have methods), not primitive actions
+            if (numMethods > 0) {
+                taskMethodCounts[taskName] = numMethods;
+                
+                // Track which method was actually used
+                if (usedMethodIds != nullptr) {
+                    int usedMethodId = names.findMethod(node.method, taskId);
+                    if (usedMethodId >= 0) {
+                        usedMethodIds->insert(usedMethodId);
+                    }
+                }
+            }
+        }
+    }
+
+    return taskMethodCounts;
+}
+
+map<string, int> parseDecompositionTreeFromLog(istream& file, Model* htn, set<int>* usedMethodIds) {
+    return parseDecompositionTreeFromLog(parsePlannerLog(file), htn, usedMethodIds);
+}
+
+map<string, int> parseDecompositionTreeFromLog(const string& logFile, Model* htn, set<int>* usedMethodIds) {
+    ifstream file(logFile);
+    if (!file.is_open()) {
+        cerr << "Warning: Cannot open log file: " << logFile << endl;
+        return map<string, int>();
+    }
+    return parseDecompositionTreeFromLog(file, htn, usedMethodIds);
+}
+
+// Get methods per task (for Stage I) - OLD VERSION, kept for compatibility
+map<int, vector<int>> getMethodsPerTask(Model* htn) {
+    map<int, vector<int>> taskToMethods;
+    for (int m = 0; m < htn->numMethods; m++) {
+        int taskId = htn->decomposedTask[m];
+        taskToMethods[taskId].push_back(m);
+    }
+    return taskToMethods;
+}
+
+// ============================================================================
+// STAGE I: NETWORK DECOMPOSITION PROBABILITY P(N | N^g)
+// ============================================================================
+
+double computeStage1Probability(const map<string, int>& taskMethodCounts, bool verbose, ostream& out) {
+    return exp(computeStage1LogProbability(taskMethodCounts, verbose, out));
+}
+
+double computeStage1LogProbability(const map<string, int>& taskMethodCounts, bool verbose, ostream& out) {
+    TRACE_SCOPE("stage1");
+    TRACE_ARG("tasks", taskMethodCounts.size());
+    double logProb = 0.0;
+    int numCompoundTasks = 0;
+    
+    if (verbose) {
+        out << "\n=== STAGE I: Network Decomposition ===" << endl;
+        out << "Using uniform method selection: P(m|X) = 1/|M(X)|" << endl;
+        out << endl;
+    }
+    
+    for (const auto& entry : taskMethodCounts) {
+        string taskName = entry.first;
+        int numMethods = entry.second;
+        double prob = 1.0;
+        if (numMethods == 0) {
+            continue;
+        }
+        prob = 1.0 / numMethods;
+        
+        if (verbose) {
+            out << "  Task: " << taskName
+                 << " | |M(X)| = " << numMethods 
+                 << " | P(m|X) = " << prob << endl;
+        }
+        
+        logProb += log(prob);
+        numCompoundTasks++;
+    }
+    
+    if (verbose) {
+        out << "\nCompound tasks with methods: " << numCompoundTasks << endl;
+        out << "log P(N | N^g) = " << logProb << endl;
+        out << "P(N | N^g) = " << exp(logProb) << endl;
+    }
+    
+    return logProb;
+}
+
+// ============================================================================
+// STAGE II: EXECUTABLE LINEARIZATION PROBABILITY P(π | N, s_0)
+// ============================================================================
+
+static inline bool testBit(const vector<uint64_t>& row, int i) {
+    return (row[i >> 6] >> (i & 63)) & 1;
+}
+
+OrderingRelation::OrderingRelation(const vector<pair<int,int>>& orderings) {
+    for (const auto& ord : orderings) {
+        for (int t : {ord.first, ord.second}) {
+            if (index.find(t) == index.end()) {
+                index[t] = tasks.size();
+                tasks.push_back(t);
+            }
+        }
+    }
+    int n = tasks.size();
+    numWords = (n + 63) / 64;
+    succ.assign(n, vector<uint64_t>(numWords, 0));
+    pred.assign(n, vector<uint64_t>(numWords, 0));
+    for (const auto& ord : orderings) {
+        int i = index[ord.first];
+        int j = index[ord.second];
+        succ[i][j >> 6] |= (uint64_t) 1 << (j & 63);
+        pred[j][i >> 6] |= (uint64_t) 1 << (i & 63);
+    }
+}
+
+void OrderingRelation::close() {
+    int n = tasks.size();
+    for (int k = 0; k < n; k++) {
+        const vector<uint64_t>& rowK = succ[k];
+        for (int i = 0; i < n; i++) {
+            if (testBit(succ[i], k)) {
+                vector<uint64_t>& rowI = succ[i];
+                for (int w = 0; w < numWords; w++) {
+                    rowI[w] |= rowK[w];
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        fill(pred[i].begin(), pred[i].end(), 0);
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (testBit(succ[i], j)) {
+                pred[j][i >> 6] |= (uint64_t) 1 << (i & 63);
+            }
+        }
+    }
+}
+
+int OrderingRelation::node(int task) const {
+    auto it = index.find(task);
+    return (it == index.end()) ? -1 : it->second;
+}
+
+bool OrderingRelation::precedes(int before, int after) const {
+    int i = node(before);
+    int j = node(after);
+    return (i >= 0) && (j >= 0) && testBit(succ[i], j);
+}
+
+size_t OrderingRelation::numPairs() const {
+    size_t num = 0;
+    for (const vector<uint64_t>& row : succ) {
+        for (uint64_t w : row) {
+            num += __builtin_popcountll(w);
+        }
+    }
+    return num;
+}
+
+set<pair<int,int>> OrderingRelation::pairs() const {
+    set<pair<int,int>> result;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        for (size_t j = 0; j < tasks.size(); j++) {
+            if (testBit(succ[i], j)) {
+                result.insert({tasks[i], tasks[j]});
+            }
+        }
+    }
+    return result;
+}
+
+OrderingRelation computeOrderingRelation(Model* htn, const set<int>* methodFilter) {
+    TRACE_SCOPE("ordering_relation");
+    vector<pair<int,int>> orderings;
+    
+    for (int m = 0; m < htn->numMethods; m++) {
+        // Skip methods not in the filter if a filter is provided
+        if (methodFilter != nullptr && methodFilter->find(m) == methodFilter->end()) {
+            continue;
+        }
+        
+        for (int i = 0; i < htn->numOrderings[m]; i += 2) {
+            int beforeIdx = htn->ordering[m][i];
+            int afterIdx = htn->ordering[m][i + 1];
+            int beforeTask = htn->subTasks[m][beforeIdx];
+            int afterTask = htn->subTasks[m][afterIdx];
+            orderings.push_back({beforeTask, afterTask});
+        }
+    }
+    
+    OrderingRelation relation(orderings);
+    relation.close();
+    TRACE_ARG("method_orderings", orderings.size());
+    TRACE_ARG("ordering_pairs", relation.numPairs());
+    return relation;
+}
+
+set<pair<int,int>> extractOrderingConstraints(Model* htn, const set<int>* methodFilter) {
+    return computeOrderingRelation(htn, methodFilter).pairs();
+}
+
+// Stage II keeps the state as a dense bitset. The preconditions of an action
+// are stored as the words of the bitset they touch together with the bits
+// needed in each word, so a check costs one AND per touched word.
+struct PrecWord {
+    int word;
+    uint64_t bits;
+};
+
+static inline void setBit(vector<uint64_t>& state, int f) {
+    state[f >> 6] |= (uint64_t) 1 << (f & 63);
+}
+
+static inline void clearBit(vector<uint64_t>& state, int f) {
+    state[f >> 6] &= ~((uint64_t) 1 << (f & 63));
+}
+
+static vector<PrecWord> precWords(Model* htn, int action) {
+    vector<PrecWord> words;
+    for (int i = 0; i < htn->numPrecs[action]; i++) {
+        int f = htn->precLists[action][i];
+        uint64_t bit = (uint64_t) 1 << (f & 63);
+        size_t j = 0;
+        while (j < words.size() && words[j].word != (f >> 6)) j++;
+        if (j == words.size()) {
+            words.push_back({f >> 6, bit});
+        } else {
+            words[j].bits |= bit;
+        }
+    }
+    return words;
+}
+
+static inline bool holds(const vector<uint64_t>& state, const vector<PrecWord>& prec) {
+    for (const PrecWord& w : prec) {
+        if ((state[w.word] & w.bits) != w.bits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double computeStage2Probability(Model* htn, const vector<int>& plan,
+                                const OrderingRelation& orderings,
+                                bool verbose, ostream& out) {
+    return exp(computeStage2LogProbability(htn, plan, orderings, verbose, out));
+}
+
+double computeStage2LogProbability(Model* htn, const vector<int>& plan,
+                                   const OrderingRelation& orderings,
+                                   bool verbose, ostream& out) {
+    TRACE_SCOPE("stage2");
+    TRACE_ARG("plan_length", plan.size());
+    
+    if (verbose) {
+        out << "\n=== STAGE II: Executable Linearization ===" << endl;
+        out << "Computing available sets based on ordering constraints" << endl;
+        out << "Ordering constraints: " << orderings.numPairs() << endl;
+        out << endl;
+    }
+    
+    // Initialize state from s0
+    vector<uint64_t> currentState((htn->numStateBits + 63) / 64, 0);
+    for (int i = 0; i < htn->s0Size; i++) {
+        setBit(currentState, htn->s0List[i]);
+    }
+    
+    // Distinct actions of the plan, index[a] is the position of action a
+    vector<int> actions;
+    vector<int> index(htn->numActions, -1);
+    for (int taskId : plan) {
+        if (taskId >= 0 && taskId < htn->numActions && index[taskId] < 0) {
+            index[taskId] = actions.size();
+            actions.push_back(taskId);
+        }
+    }
+    int numPlanActions = actions.size();
+    
+    // Only orderings between two actions of the plan can make an action wait,
+    // so each action counts its unexecuted predecessors among them
+    vector<int> nodeToAction(orderings.tasks.size(), -1);
+    vector<int> actionNode(numPlanActions);
+    vector<uint64_t> planNodes(orderings.numWords, 0);
+    for (int i = 0; i < numPlanActions; i++) {
+        actionNode[i] = orderings.node(actions[i]);
+        if (actionNode[i] >= 0) {
+            nodeToAction[actionNode[i]] = i;
+            planNodes[actionNode[i] >> 6] |= (uint64_t) 1 << (actionNode[i] & 63);
+        }
+    }
+    vector<int> numUnexecutedPreds(numPlanActions, 0);
+    vector<vector<int>> successors(numPlanActions);
+    for (int i = 0; i < numPlanActions; i++) {
+        int n = actionNode[i];
+        if (n < 0) {
+            continue;
+        }
+        for (int w = 0; w < orderings.numWords; w++) {
+            numUnexecutedPreds[i] += __builtin_popcountll(orderings.pred[n][w] & planNodes[w]);
+            uint64_t bits = orderings.succ[n][w] & planNodes[w];
+            while (bits) {
+                int succ = w * 64 + __builtin_ctzll(bits);
+                successors[i].push_back(nodeToAction[succ]);
+                bits &= bits - 1;
+            }
+        }
+    }
+    
+    vector<vector<PrecWord>> precs(numPlanActions);
+    for (int i = 0; i < numPlanActions; i++) {
+        precs[i] = precWords(htn, actions[i]);
+    }
+    
+    // actions not executed yet (unordered, removed by swapping with the last)
+    vector<int> remaining(numPlanActions);
+    vector<int> posInRemaining(numPlanActions);
+    for (int i = 0; i < numPlanActions; i++) {
+        remaining[i] = i;
+        posInRemaining[i] = i;
+    }
+    
+    double logProb = 0.0;
+    long long availableSum = 0;
+    int availableMax = 0;
+    
+    for (size_t t = 0; t < plan.size(); t++) {
+        int selectedAction = plan[t];
+        
+        // Available actions: minimal w.r.t. the partial order (no unexecuted
+        // predecessors) and applicable in the current state
+        int applicableCount = 0;
+        for (int i : remaining) {
+            if (numUnexecutedPreds[i] == 0 && holds(currentState, precs[i])) {
+                applicableCount++;
+            }
+        }
+        
+        if (applicableCount == 0) applicableCount = 1; // Avoid division by zero
+        availableSum += applicableCount;
+        availableMax = max(availableMax, applicableCount);
+        
+        double stepProb = 1.0 / applicableCount;
+        logProb += log(stepProb);
+        
+        if (verbose) {
+            out << "  Step " << (t+1) << ": " << htn->taskNames[selectedAction] 
+                 << " | |A_" << (t+1) << "| = " << applicableCount 
+                 << " | P = " << scientific << stepProb << endl;
+        }
+        
+        // Execute the action
+        for (int i = 0; i < htn->numDels[selectedAction]; i++) {
+            clearBit(currentState, htn->delLists[selectedAction][i]);
+        }
+        for (int i = 0; i < htn->numAdds[selectedAction]; i++) {
+            setBit(currentState, htn->addLists[selectedAction][i]);
+        }
+        int executed = (selectedAction < htn->numActions) ? index[selectedAction] : -1;
+        if (executed >= 0 && posInRemaining[executed] >= 0) {
+            int last = remaining.back();
+            remaining[posInRemaining[executed]] = last;
+            posInRemaining[last] = posInRemaining[executed];
+            remaining.pop_back();
+            posInRemaining[executed] = -1;
+            for (int succ : successors[executed]) {
+                numUnexecutedPreds[succ]--;
+            }
+        }
+    }
+    
+    TRACE_ARG("available_actions_sum", availableSum);
+    TRACE_ARG("available_actions_max", availableMax);
+    if (verbose) {
+        out << "\nlog P(π | N, s_0) = " << scientific << logProb << " nats" << endl;
+        out << "P(π | N, s_0) = " << scientific << exp(logProb) << endl;
+    }
+    
+    return logProb;
+}
+
+double computeStage2Probability(Model* htn, const vector<int>& plan,
+                                const set<pair<int,int>>& orderingConstraints,
+                                bool verbose, ostream& out) {
+    OrderingRelation orderings(vector<pair<int,int>>(orderingConstraints.begin(), orderingConstraints.end()));
+    return computeStage2Probability(htn, plan, orderings, verbose, out);
+}
+
+// ============================================================================
+// STAGE III: OBSERVATION GENERATION PROBABILITY P(ô | π)
+// ============================================================================
+
+// uniform over the prefix lengths 0..planLength, the same for every t
+double progressPrior(int /* t */, int planLength) {
+    return 1.0 / (planLength + 1);
+}
+
+double alignmentLikelihoodFullObs(const vector<int>& observations, const vector<int>& planPrefix) {
+    if (observations.size() != planPrefix.size()) {
+        return 0.0;
+    }
+    
+    for (size_t i = 0; i < observations.size(); i++) {
+        if (observations[i] != planPrefix[i]) {
+            return 0.0;
+        }
+    }
+    
+    return 1.0;
+}
+
+// log(exp(a) + exp(b)), also for a or b = -inf
+static inline double logAdd(double a, double b) {
+    if (a < b) swap(a, b);
+    if (b == -INFINITY) return a;
+    return a + log1p(exp(b - a));
+}
+
+// Forward pass of the partial observability alignment over one plan:
+// afterwards col[i] = log P(ô_{1:i} | π_{1:j}) for the last j processed.
+// dp[i][j] only depends on column j-1, so a single column updated from the
+// bottom up suffices, and every prefix length is one step of the same pass.
+class PartialObsAlignment {
+public:
+    PartialObsAlignment(const vector<int>& observations, double pDet)
+        : observations(observations), logDet(log(pDet)), logMiss(log(1 - pDet)),
+          col(observations.size() + 1, -INFINITY) {
+        col[0] = 0.0;
+    }
+
+    // extends the prefix by one plan step
+    void step(int action) {
+        for (size_t i = observations.size(); i > 0; i--) {
+            double match = (observations[i-1] == action) ? col[i-1] + logDet : -INFINITY;
+            double skip = col[i] + logMiss;
+            col[i] = logAdd(match, skip);
+        }
+        col[0] += logMiss;
+    }
+
+    // log P(ô | π_{1:j})
+    double logLikelihood() const {
+        return col.back();
+    }
+
+private:
+    const vector<int>& observations;
+    double logDet;
+    double logMiss;
+    vector<double> col;
+};
+
+double alignmentLikelihoodPartialObs(const vector<int>& observations, 
+                                     const vector<int>& planPrefix, 
+                                     double pDet) {
+    if (observations.size() > planPrefix.size()) return 0.0;
+    
+    PartialObsAlignment alignment(observations, pDet);
+    for (int action : planPrefix) {
+        alignment.step(action);
+    }
+    return exp(alignment.logLikelihood());
+}
+
+double computeStage3Probability(const vector<int>& observations, 
+                               const vector<int>& plan,
+                               bool fullObservability,
+                               double pDet,
+                               Model* htn,
+                               bool verbose, ostream& out) {
+    return exp(computeStage3LogProbability(observations, plan, fullObservability, pDet, htn, verbose, out));
+}
+
+double computeStage3LogProbability(const vector<int>& observations,
+                                   const vector<int>& plan,
+                                   bool fullObservability,
+                                   double pDet,
+                                   Model* /* htn, unused */,
+                                   bool verbose, ostream& out) {
+    TRACE_SCOPE("stage3");
+    TRACE_ARG("observations", observations.size());
+    TRACE_ARG("plan_length", plan.size());
+    
+    if (verbose) {
+        out << "\n=== STAGE III: Observation Generation ===" << endl;
+        out << "Observations: " << observations.size() << " actions" << endl;
+        out << "Plan: " << plan.size() << " actions" << endl;
+        out << "Full observability: " << (fullObservability ? "yes" : "no") << endl;
+    }
+    
+    if (fullObservability) {
+        double progress = progressPrior(observations.size(), plan.size());
+        vector<int> planPrefix(plan.begin(), plan.begin() + min(observations.size(), plan.size()));
+        double alignment = alignmentLikelihoodFullObs(observations, planPrefix);
+        double logProb = (alignment > 0.0) ? log(progress) : -INFINITY;
+        
+        if (verbose) {
+            out << "P(Execute " << observations.size() << " actions | π) = " << progress << endl;
+            out << "1[π_{1:" << observations.size() << "} = ô] = " << alignment << endl;
+            out << "P(ô | π) = " << progress * alignment << endl;
+        }
+        
+        return logProb;
+    } else {
+        double logTotal = -INFINITY;
+        
+        if (verbose) {
+            out << "\nMarginalizing over execution progress:" << endl;
+        }
+        
+        // one forward pass over the plan yields the alignment of every prefix
+        PartialObsAlignment forward(observations, pDet);
+        for (size_t t = 0; t < observations.size() && t < plan.size(); t++) {
+            forward.step(plan[t]);
+        }
+        for (size_t t = observations.size(); t <= plan.size(); t++) {
+            if (t > observations.size()) {
+                forward.step(plan[t-1]);
+            }
+            double logProgress = log(progressPrior(t, plan.size()));
+            double logContribution = logProgress + forward.logLikelihood();
+            logTotal = logAdd(logTotal, logContribution);
+            
+            if (verbose && logContribution > log(1e-10)) {
+                out << "  t=" << t << ": P(Execute " << t << " | π) = " << exp(logProgress)
+                     << ", P(ô | π_{1:" << t << "}) = " << exp(forward.logLikelihood())
+                     << ", contribution = " << exp(logContribution) << endl;
+            }
+        }
+        
+        if (verbose) {
+            out << "\nP(ô | π) = " << exp(logTotal) << endl;
+        }
+        
+        return logTotal;
+    }
+}
+IncrementalStage3::IncrementalStage3(const vector<int>& plan, bool fullObservability, double pDet)
+    : plan(plan), fullObservability(fullObservability), logDet(log(pDet)), logMiss(log(1 - pDet)) {
+    if (!fullObservability) {
+        // no observations: every prefix has skipped all of its steps
+        row.resize(plan.size() + 1);
+        row[0] = 0.0;
+        for (size_t t = 1; t <= plan.size(); t++) {
+            row[t] = row[t-1] + logMiss;
+        }
+    }
+}
+
+// the row of the next observation from the current one, as PartialObsAlignment::step() fills it
+void IncrementalStage3::addObservation(int action) {
+    numObs++;
+    if (fullObservability) {
+        prefixMatches = prefixMatches && (numObs <= (int) plan.size()) && (plan[numObs-1] == action);
+        return;
+    }
+    double previous = row[0];
+    row[0] = -INFINITY;
+    for (size_t t = 1; t <= plan.size(); t++) {
+        double match = (plan[t-1] == action) ? previous + logDet : -INFINITY;
+        double skip = row[t-1] + logMiss;
+        previous = row[t];
+        row[t] = logAdd(match, skip);
+    }
+}
+
+double IncrementalStage3::logProbability() const {
+    if (fullObservability) {
+        return prefixMatches ? log(progressPrior(numObs, plan.size())) : -INFINITY;
+    }
+    double logTotal = -INFINITY;
+    for (size_t t = numObs; t <= plan.size(); t++) {
+        logTotal = logAdd(logTotal, log(progressPrior(t, plan.size())) + row[t]);
+    }
+    return logTotal;
+}
+
+bool IncrementalStage3::consistent() const {
+    return logProbability() > -INFINITY;
+}
+
+int IncrementalStage3::numObservations() const {
+    return numObs;
+}
+
+vector<int> stage3Observations(const vector<int>& obsPlan, int numObservations) {
+    if (numObservations < 0 || numObservations > (int) obsPlan.size()) {
+        return obsPlan;
+    }
+    return vector<int>(obsPlan.begin(), obsPlan.begin() + numObservations);
+}
+
+// ============================================================================
+// NORMALIZED LIKELIHOOD COMPUTATION
+// ============================================================================
+
+// the plan steps and tree tasks are looked up ignoring case, the methods by their exact name
+void addLogNames(const ParsedLog& log, ModelSelection& selection) {
+    for (const string& step : log.plan) {
+        selection.tasks.insert(NameIndex::lowerCase(step));
+    }
+    for (const LogTreeNode& node : log.tree) {
+        selection.tasks.insert(NameIndex::lowerCase(node.task));
+        selection.methods.insert(node.method);
+    }
+}
+
+// the plan of a log as action ids of htn, via the interned names if the log has them
+vector<int> planToActionIds(Model* htn, const ParsedLog& log) {
+    const vector<string>& planStrings = log.plan;
+    bool interned = (log.planSymbols.size() == planStrings.size());
+    vector<int> plan;
+    plan.reserve(planStrings.size());
+    const NameIndex& names = htn->names();
+    for (size_t i = 0; i < planStrings.size(); i++) {
+        int actionId = interned ? names.findTask(log.planSymbols[i]) : -1;
+        if (actionId < 0) {
+            actionId = names.findTaskIgnoreCase(planStrings[i]);
+        }
+        if (actionId >= 0 && actionId < htn->numActions) {
+            plan.push_back(actionId);
+        }
+    }
+    return plan;
+}
+
+LikelihoodResult computeNormalizedLikelihood(Model* htn,
+                                             const string& observationLog,
+                                             const string& baselineLog,
+                                             const LikelihoodOptions& options) {
+    return computeNormalizedLikelihood(htn, parsePlannerLog(observationLog), parsePlannerLog(baselineLog), options);
+}
+
+LikelihoodResult computeNormalizedLikelihood(Model* htn,
+                                             const ParsedLog& observationLog,
+                                             const ParsedLog& baselineLog,
+                                             const LikelihoodOptions& options) {
+    TRACE_SCOPE("likelihood");
+    LikelihoodResult result;
+    bool verbose = options.verbose;
+    ostream& out = *options.log;
+
+    // Parse observation plan (π^+)
+    const vector<string>& obsPlanStrings = observationLog.plan;
+    if (obsPlanStrings.empty()) {
+        cerr << "Error: No plan found in observation log file" << endl;
+        return result;
+    }
+    vector<int> obsPlan = planToActionIds(htn, observationLog);
+
+    // Parse baseline plan (π_base)
+    const vector<string>& basePlanStrings = baselineLog.plan;
+    if (basePlanStrings.empty()) {
+        cerr << "Error: No plan found in baseline log file" << endl;
+        return result;
+    }
+    vector<int> basePlan = planToActionIds(htn, baselineLog);
+
+    if (verbose) {
+        out << "\nObservation plan (π^+): " << obsPlan.size() << " actions" << endl;
+        out << "Baseline plan (π_base): " << basePlan.size() << " actions" << endl;
+    }
+
+    // Prepare observations
+    vector<int> observations = stage3Observations(obsPlan, options.numObservations);
+    int numObservations = observations.size();
+
+    if (verbose) {
+        out << "Using " << numObservations << " observations" << endl;
+    }
+
+    // Parse decomposition trees to get task-method counts and track used methods
+    set<int> usedMethodIds;
+    map<string, int> obsTaskMethodCounts = parseDecompositionTreeFromLog(observationLog, htn, &usedMethodIds);
+    map<string, int> baseTaskMethodCounts = parseDecompositionTreeFromLog(baselineLog, htn, &usedMethodIds);
+
+    // Extract ordering constraints only from methods actually used in the decomposition
+    if (verbose) {
+        out << "Extracting ordering constraints from " << usedMethodIds.size() << " used methods (out of " << htn->numMethods << " total)..." << endl;
+    }
+    OrderingRelation orderingConstraints = computeOrderingRelation(htn, &usedMethodIds);
+    if (verbose) {
+        out << "Extraction complete. Found " << orderingConstraints.numPairs() << " ordering constraints." << endl;
+    }
+
+    // ========================================================================
+    // STEP 1: COMPUTE NUMERATOR P̃(ô, π^+, N^+ | N^g, s_0)
+    // ========================================================================
+
+    if (verbose) {
+        out << "\n" << string(60, '=') << endl;
+        out << "STEP 1: Numerator - Observation-Consistent Execution" << endl;
+        out << string(60, '=') << endl;
+    }
+    double obs_stage1 = computeStage1LogProbability(obsTaskMethodCounts, verbose, out);
+    double obs_stage2 = computeStage2LogProbability(htn, obsPlan, orderingConstraints, verbose, out);
+    double obs_stage3 = computeStage3LogProbability(observations, obsPlan, options.fullObservability, options.pDet, htn, verbose, out);
+
+    double log_numerator = obs_stage1 + obs_stage2 + obs_stage3;
+
+    if (verbose) {
+        out << "\nNumerator: P̃(ô, π^+, N^+ | N^g, s_0) = " << scientific << exp(log_numerator) << endl;
+    }
+
+    // ========================================================================
+    // STEP 2: COMPUTE DENOMINATOR P̃(N_base, π_base | N^g, s_0)
+    // ========================================================================
+
+    if (verbose) {
+        out << "\n" << string(60, '=') << endl;
+        out << "STEP 2: Denominator - Baseline Unconstrained Execution" << endl;
+        out << string(60, '=') << endl;
+    }
+
+    double base_stage1 = computeStage1LogProbability(baseTaskMethodCounts, verbose, out);
+    double base_stage2 = computeStage2LogProbability(htn, basePlan, orderingConstraints, verbose, out);
+
+    double log_denominator = base_stage1 + base_stage2;
+
+    if (verbose) {
+        out << "\nDenominator: P̃(N_base, π_base | N^g, s_0) = " << scientific << exp(log_denominator) << endl;
+    }
+
+    // ========================================================================
+    // STEP 3: COMPUTE NORMALIZED LIKELIHOOD
+    // ========================================================================
+
+    // the ratio is taken in log space, numerator and denominator of long plans underflow
+    double log_likelihood = log_numerator - log_denominator;
+
+    if (verbose) {
+        out << "\n" << string(60, '=') << endl;
+        out << "FINAL RESULTS" << endl;
+        out << string(60, '=') << endl;
+        out << fixed << setprecision(10);
+        out << "\nNumerator (ô, π^+, N^+):" << endl;
+        out << "  Stage I:   P(N^+ | N^g)       = " << exp(obs_stage1) << endl;
+        out << "  Stage II:  P(π^+ | N^+, s_0)  = " << exp(obs_stage2) << endl;
+        out << "  Stage III: P(ô | π^+)         = " << exp(obs_stage3) << endl;
+        out << "  Product:   P̃(ô, π^+, N^+)    = " << scientific << exp(log_numerator) << endl;
+
+        out << "\nDenominator (baseline):" << endl;
+        out << "  Stage I:   P(N_base | N^g)          = " << fixed << exp(base_stage1) << endl;
+        out << "  Stage II:  P(π_base | N_base, s_0)  = " << scientific << exp(base_stage2) << endl;
+        out << "  Product:   P̃(N_base, π_base)       = " << exp(log_denominator) << endl;
+
+        out << "\n" << string(60, '-') << endl;
+        out << "Normalized Likelihood:" << endl;
+        out << "  P̂(ô | N^g, s_0) = " << exp(log_likelihood) << endl;
+        out << "  log P̂(ô | N^g, s_0) = " << fixed << log_likelihood << endl;
+        out << string(60, '=') << endl;
+    }
+
+    result.ok = true;
+    result.obsPlanLength = obsPlan.size();
+    result.basePlanLength = basePlan.size();
+    result.numObservations = numObservations;
+    result.logObsStage1 = obs_stage1;
+    result.logObsStage2 = obs_stage2;
+    result.logObsStage3 = obs_stage3;
+    result.logBaseStage1 = base_stage1;
+    result.logBaseStage2 = base_stage2;
+    result.logNumerator = log_numerator;
+    result.logDenominator = log_denominator;
+    result.logLikelihood = log_likelihood;
+    result.obsStage1 = exp(obs_stage1);
+    result.obsStage2 = exp(obs_stage2);
+    result.obsStage3 = exp(obs_stage3);
+    result.baseStage1 = exp(base_stage1);
+    result.baseStage2 = exp(base_stage2);
+    result.numerator = exp(log_numerator);
+    result.denominator = exp(log_denominator);
+    result.normalizedLikelihood = exp(log_likelihood);
+    return result;
+}
+
+// ============================================================================
+// POSTERIOR OVER HYPOTHESES
+// ============================================================================
+
+double logSumExp(const vector<double>& values) {
+    double maxValue = -INFINITY;
+    for (double v : values) {
+        maxValue = max(maxValue, v);
+    }
+    if (maxValue == -INFINITY || !isfinite(maxValue)) {
+        return maxValue;
+    }
+    double sum = 0.0;
+    for (double v : values) {
+        sum += exp(v - maxValue);
+    }
+    return maxValue + log(sum);
+}
+
+vector<double> normalizeLogLikelihoods(const vector<double>& logLikelihoods) {
+    double logTotal = logSumExp(logLikelihoods);
+    vector<double> logPosteriors(logLikelihoods.size(), -INFINITY);
+    if (!isfinite(logTotal)) {
+        return logPosteriors;
+    }
+    for (size_t i = 0; i < logLikelihoods.size(); i++) {
+        logPosteriors[i] = logLikelihoods[i] - logTotal;
+    }
+    return logPosteriors;
+}
+
+vector<HypothesisPosterior> computePosteriors(const vector<HypothesisLogs>& hypotheses,
+                                              const LikelihoodOptions& options) {
+    vector<HypothesisPosterior> results(hypotheses.size());
+    vector<double> logLikelihoods(hypotheses.size(), -INFINITY);
+    for (size_t i = 0; i < hypotheses.size(); i++) {
+        const HypothesisLogs& h = hypotheses[i];
+        results[i].hypothesis = h.hypothesis;
+        if (h.htn == nullptr || h.observationLog == nullptr || h.baselineLog == nullptr) {
+            continue;
+        }
+        results[i].likelihood = computeNormalizedLikelihood(h.htn, *h.observationLog, *h.baselineLog, options);
+        if (results[i].likelihood.ok && !isnan(results[i].likelihood.logLikelihood)) {
+            logLikelihoods[i] = results[i].likelihood.logLikelihood;
+        }
+    }
+
+    vector<double> logPosteriors = normalizeLogLikelihoods(logLikelihoods);
+    for (size_t i = 0; i < results.size(); i++) {
+        results[i].logPosterior = logPosteriors[i];
+        results[i].posterior = exp(logPosteriors[i]);
+    }
+    return results;
+}
@@ -0,0 +1,231 @@
+/**
+ * Normalized likelihood for HTN goal recognition
+ *
+ * Implements: P̂(ô | N^g, s_0) ≈ P̃(ô, π^+, N^+ | N^g, s_0) / P̃(N_base, π_base | N^g, s_0)
+ *
+ * The three stages (network decomposition, executable linearization and
+ * observation generation) are exposed individually, and
+ * computeNormalizedLikelihood() chains them for one observation/baseline pair.
+ * Planner logs are consumed from streams or as a ParsedLog (see
+ * PlannerLogParser.h) so that callers which already hold a log in memory do
+ * not need to go through the file system or read it twice.
+ *
+ * All stages are computed in log space; the linear values are only derived
+ * for output, they underflow to 0 for long plans. computePosteriors()
+ * evaluates a batch of hypotheses and normalizes them with log-sum-exp.
+ */
+
+#ifndef NORMALIZEDLIKELIHOOD_H_
+#define NORMALIZEDLIKELIHOOD_H_
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <map>
+#include <set>
+#include <unordered_set>
+#include "../htnModel/Model.h"
+#include "PlannerLogParser.h"
+
+using namespace std;
+using namespace progression;
+
+struct LikelihoodOptions {
+    double alpha = 1.0;             // inverse temperature for Stage I
+    int numObservations = -1;       // -1 = use all observations
+    bool fullObservability = true;
+    double pDet = 0.9;              // detection probability (partial observability)
+    bool verbose = true;
+    ostream* log = &cout;           // verbose output, one stream per concurrent computation
+};
+
+struct LikelihoodResult {
+    bool ok = false;
+    int obsPlanLength = 0;
+    int basePlanLength = 0;
+    int numObservations = 0;
+    double obsStage1 = 0.0;
+    double obsStage2 = 0.0;
+    double obsStage3 = 0.0;
+    double baseStage1 = 0.0;
+    double baseStage2 = 0.0;
+    double numerator = 0.0;
+    double denominator = 0.0;
+    double normalizedLikelihood = 0.0;
+    // the same in log space (natural logarithm, -inf for probability 0)
+    double logObsStage1 = -INFINITY;
+    double logObsStage2 = -INFINITY;
+    double logObsStage3 = -INFINITY;
+    double logBaseStage1 = -INFINITY;
+    double logBaseStage2 = -INFINITY;
+    double logNumerator = -INFINITY;
+    double logDenominator = -INFINITY;
+    double logLikelihood = -INFINITY;
+};
+
+// ============================================================================
+// PLANNER LOG PARSING
+// ============================================================================
+
+vector<string> parsePlanFromLog(istream& log);
+vector<string> parsePlanFromLog(const string& logFile);
+
+// Parse decomposition tree from planner log to get task-method pairs actually used
+// Returns map of task name -> number of alternative methods for that task
+// Also populates usedMethodIds with the actual method IDs that were used
+map<string, int> parseDecompositionTreeFromLog(const ParsedLog& log, Model* htn, set<int>* usedMethodIds = nullptr);
+map<string, int> parseDecompositionTreeFromLog(istream& log, Model* htn, set<int>* usedMethodIds = nullptr);
+map<string, int> parseDecompositionTreeFromLog(const string& logFile, Model* htn, set<int>* usedMethodIds = nullptr);
+
+// the plan of a log as action ids of htn (steps that are not actions of htn are dropped)
+vector<int> planToActionIds(Model* htn, const ParsedLog& log);
+
+// adds the tasks and methods that computeNormalizedLikelihood() looks up for
+// log, a model read with Model::readSelected() of them gives the same result
+void addLogNames(const ParsedLog& log, ModelSelection& selection);
+
+// ============================================================================
+// MODEL HELPERS
+// ============================================================================
+
+int findTaskId(Model* htn, const string& name);
+int findMethodId(Model* htn, const string& methodName, int taskId);
+bool isApplicable(Model* htn, const unordered_set<int>& state, int action);
+void applyAction(Model* htn, unordered_set<int>& state, int action);
+map<int, vector<int>> getMethodsPerTask(Model* htn);
+
+// ============================================================================
+// STAGES
+// ============================================================================
+
+// the linear stage probabilities are exp() of the log versions
+double computeStage1Probability(const map<string, int>& taskMethodCounts, bool verbose = true, ostream& out = cout);
+double computeStage1LogProbability(const map<string, int>& taskMethodCounts, bool verbose = true, ostream& out = cout);
+
+// Ordering relation between the tasks of a set of methods as a bit matrix:
+// succ[i] / pred[i] hold the (indices of the) tasks after / before tasks[i].
+struct OrderingRelation {
+    vector<int> tasks;               // task ids of the nodes
+    map<int, int> index;             // task id -> node
+    int numWords = 0;                // words per row
+    vector<vector<uint64_t>> succ;
+    vector<vector<uint64_t>> pred;
+
+    OrderingRelation() {}
+    explicit OrderingRelation(const vector<pair<int,int>>& orderings); // taken as given, not closed
+    void close(); // transitive closure (Warshall over 64-bit words)
+    int node(int task) const; // -1 if the task is not ordered
+    bool precedes(int before, int after) const;
+    size_t numPairs() const;
+    set<pair<int,int>> pairs() const;
+};
+
+// Transitive ordering relation of the methods in methodFilter (all if nullptr)
+OrderingRelation computeOrderingRelation(Model* htn, const set<int>* methodFilter = nullptr);
+set<pair<int,int>> extractOrderingConstraints(Model* htn, const set<int>* methodFilter = nullptr);
+double computeStage2Probability(Model* htn, const vector<int>& plan,
+                                const OrderingRelation& orderings,
+                                bool verbose = true, ostream& out = cout);
+double computeStage2LogProbability(Model* htn, const vector<int>& plan,
+                                   const OrderingRelation& orderings,
+                                   bool verbose = true, ostream& out = cout);
+double computeStage2Probability(Model* htn, const vector<int>& plan,
+                                const set<pair<int,int>>& orderingConstraints,
+                                bool verbose = true, ostream& out = cout);
+
+double progressPrior(int t, int planLength);
+double alignmentLikelihoodFullObs(const vector<int>& observations, const vector<int>& planPrefix);
+double alignmentLikelihoodPartialObs(const vector<int>& observations,
+                                     const vector<int>& planPrefix,
+                                     double pDet);
+double computeStage3Probability(const vector<int>& observations,
+                               const vector<int>& plan,
+                               bool fullObservability,
+                               double pDet,
+                               Model* htn,
+                               bool verbose = true, ostream& out = cout);
+double computeStage3LogProbability(const vector<int>& observations,
+                                   const vector<int>& plan,
+                                   bool fullObservability,
+                                   double pDet,
+                                   Model* htn,
+                                   bool verbose = true, ostream& out = cout);
+
+// The observations of Stage III: the first numObservations steps of the
+// observation-consistent plan π^+, all of them for -1 or more than it has.
+// computeNormalizedLikelihood and the served updates of the driver both use
+// it, so a served posterior equals that of a run with the same num_obs.
+vector<int> stage3Observations(const vector<int>& obsPlan, int numObservations);
+
+// Stage III of one plan for observations that arrive one at a time. Keeps
+// log P(ô_{1:n} | π_{1:t}) for every prefix length t of the plan, so an added
+// observation costs one pass over the plan instead of one over all of them.
+// logProbability() equals computeStage3LogProbability() of the observations
+// added so far.
+class IncrementalStage3 {
+public:
+    IncrementalStage3(const vector<int>& plan, bool fullObservability, double pDet);
+
+    void addObservation(int action);
+    double logProbability() const;
+    // false once the plan cannot produce the observations any more
+    bool consistent() const;
+    int numObservations() const;
+
+private:
+    vector<int> plan;
+    bool fullObservability;
+    double logDet;
+    double logMiss;
+    int numObs = 0;
+    bool prefixMatches = true;      // full observability: π_{1:n} = ô
+    vector<double> row;             // partial observability: row[t] = log P(ô_{1:n} | π_{1:t})
+};
+
+// ============================================================================
+// NORMALIZED LIKELIHOOD
+// ============================================================================
+
+// Both logs are passed as their full text (as written by the planner).
+LikelihoodResult computeNormalizedLikelihood(Model* htn,
+                                             const string& observationLog,
+                                             const string& baselineLog,
+                                             const LikelihoodOptions& options);
+LikelihoodResult computeNormalizedLikelihood(Model* htn,
+                                             const ParsedLog& observationLog,
+                                             const ParsedLog& baselineLog,
+                                             const LikelihoodOptions& options);
+
+// ============================================================================
+// POSTERIOR OVER HYPOTHESES
+// ============================================================================
+
+// one hypothesis of a batch: the model of its baseline problem and both logs
+struct HypothesisLogs {
+    string hypothesis;
+    Model* htn = nullptr;
+    const ParsedLog* observationLog = nullptr;
+    const ParsedLog* baselineLog = nullptr;
+};
+
+struct HypothesisPosterior {
+    string hypothesis;
+    LikelihoodResult likelihood;    // not ok: the hypothesis gets posterior 0
+    double logPosterior = -INFINITY;
+    double posterior = 0.0;
+};
+
+// log(sum exp(x)), -inf for no values or only -inf
+double logSumExp(const vector<double>& values);
+
+// log posteriors under a uniform prior: logLikelihoods[i] - logSumExp(logLikelihoods);
+// all -inf if no likelihood is positive
+vector<double> normalizeLogLikelihoods(const vector<double>& logLikelihoods);
+
+// likelihoods and posteriors of all hypotheses, in the given order
+vector<HypothesisPosterior> computePosteriors(const vector<HypothesisLogs>& hypotheses,
+                                              const LikelihoodOptions& options);
+
+#endif /* NORMALIZEDLIKELIHOOD_H_ */
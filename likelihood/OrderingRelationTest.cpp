@@ -0,0 +1,115 @@
+/**
+ * Transitive closure of the ordering bit matrix against the pairwise fixpoint
+ * it replaced, on random methods (with cycles) and method filters.
+ * Returns nonzero if a case disagrees.
+ */
+
+#include <random>
+#include "NormalizedLikelihood.h"
+
+// the closure as it was computed before the bit matrix: join all pairs until
+// nothing new is added
+static set<pair<int,int>> referenceOrderingConstraints(Model* htn, const set<int>* methodFilter) {
+    set<pair<int,int>> orderings;
+    for (int m = 0; m < htn->numMethods; m++) {
+        if (methodFilter != nullptr && methodFilter->find(m) == methodFilter->end()) {
+            continue;
+        }
+        for (int i = 0; i < htn->numOrderings[m]; i += 2) {
+            orderings.insert({htn->subTasks[m][htn->ordering[m][i]],
+                              htn->subTasks[m][htn->ordering[m][i + 1]]});
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        set<pair<int,int>> newPairs;
+        for (const auto& p1 : orderings) {
+            for (const auto& p2 : orderings) {
+                if (p1.second == p2.first && orderings.find({p1.first, p2.second}) == orderings.end()) {
+                    newPairs.insert({p1.first, p2.second});
+                    changed = true;
+                }
+            }
+        }
+        orderings.insert(newPairs.begin(), newPairs.end());
+    }
+    return orderings;
+}
+
+// methods over a pool of numTasks tasks, so that tasks recur between methods
+// and the relation gets cycles. Only the method arrays are set, it is not
+// deleted since ~Model() expects the rest of what read() sets up.
+static Model* randomMethods(mt19937& rng, int numMethods, int numTasks) {
+    Model* htn = new Model();
+    htn->numTasks = numTasks;
+    htn->numMethods = numMethods;
+    htn->numSubTasks = new int[max(numMethods, 1)];
+    htn->subTasks = new int*[max(numMethods, 1)];
+    htn->numOrderings = new int[max(numMethods, 1)];
+    htn->ordering = new int*[max(numMethods, 1)];
+    for (int m = 0; m < numMethods; m++) {
+        int n = uniform_int_distribution<int>(0, 6)(rng);
+        htn->numSubTasks[m] = n;
+        htn->subTasks[m] = new int[max(n, 1)];
+        for (int i = 0; i < n; i++) {
+            htn->subTasks[m][i] = uniform_int_distribution<int>(0, numTasks - 1)(rng);
+        }
+        vector<int> pairs;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (i != j && uniform_int_distribution<int>(0, 3)(rng) == 0) {
+                    pairs.push_back(i);
+                    pairs.push_back(j);
+                }
+            }
+        }
+        htn->numOrderings[m] = pairs.size();
+        htn->ordering[m] = new int[max((int) pairs.size(), 1)];
+        copy(pairs.begin(), pairs.end(), htn->ordering[m]);
+    }
+    return htn;
+}
+
+int main() {
+    mt19937 rng(20240612);
+    int failures = 0;
+    int cases = 0;
+
+    for (int run = 0; run < 200; run++) {
+        // more than 64 ordered tasks in some runs, so the rows span several words
+        int numTasks = uniform_int_distribution<int>(1, (run % 3 == 0) ? 150 : 15)(rng);
+        int numMethods = uniform_int_distribution<int>(0, (run % 3 == 0) ? 60 : 10)(rng);
+        Model* htn = randomMethods(rng, numMethods, numTasks);
+
+        for (int f = 0; f < 3; f++) {
+            set<int> filter;
+            for (int m = 0; m < numMethods; m++) {
+                if (uniform_int_distribution<int>(0, 1)(rng)) {
+                    filter.insert(m);
+                }
+            }
+            const set<int>* methodFilter = (f == 0) ? nullptr : &filter;
+
+            set<pair<int,int>> expected = referenceOrderingConstraints(htn, methodFilter);
+            OrderingRelation relation = computeOrderingRelation(htn, methodFilter);
+            bool agree = (relation.pairs() == expected) && (relation.numPairs() == expected.size())
+                    && (extractOrderingConstraints(htn, methodFilter) == expected);
+            for (int a = 0; agree && a < numTasks; a++) {
+                for (int b = 0; agree && b < numTasks; b++) {
+                    agree = relation.precedes(a, b) == (expected.count({a, b}) > 0);
+                }
+            }
+            cases++;
+            if (!agree) {
+                failures++;
+                cerr << "run " << run << " filter " << f << ": expected " << expected.size()
+                     << " pairs, got " << relation.numPairs() << endl;
+            }
+        }
+    }
+
+    cout << "Ordering relation: " << (cases - failures) << "/" << cases << " cases agree" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+/**
+ * Single-pass reader for pplanner logs, see PlannerLogParser.h
+ *
+ * Each part of the result has its own small state machine, all of them are
+ * advanced line by line in the same pass (PlannerLogReader::readLine()).
+ * They reproduce the line-based readers the tools used before, each of which
+ * read the whole log again.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include "PlannerLogParser.h"
+#include "../htnModel/Trace.h"
+
+static string trimmed(const string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+static inline bool has(const string& s, const char* sub) {
+    return s.find(sub) != string::npos;
+}
+
+static inline bool startsWith(const string& s, const char* prefix) {
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// integer at pos like stoi (leading whitespace and sign), false if there is none
+static bool readInt(const string& s, size_t pos, int& value) {
+    while (pos < s.size() && isspace((unsigned char) s[pos])) pos++;
+    bool negative = false;
+    if (pos < s.size() && (s[pos] == '-' || s[pos] == '+')) {
+        negative = (s[pos] == '-');
+        pos++;
+    }
+    if (pos >= s.size() || !isdigit((unsigned char) s[pos])) return false;
+    long long v = 0;
+    while (pos < s.size() && isdigit((unsigned char) s[pos])) {
+        v = v * 10 + (s[pos++] - '0');
+        if (v > 2147483647LL) return false;
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+// first token of s up to a space
+static inline string firstToken(const string& s) {
+    return s.substr(0, s.find(' '));
+}
+
+// the first "name[args]" that starts the encoding or follows ';' or ' ', and
+// is followed by ';' or whitespace, e.g. "set-up-shelter[mendon-pond]"
+static bool findGroundedTask(const string& enc, string& task) {
+    for (size_t g = 0; g < enc.size(); g++) {
+        if (g > 0 && enc[g - 1] != ';' && enc[g - 1] != ' ') continue;
+        size_t i = g;
+        while (i < enc.size() && (isalnum((unsigned char) enc[i]) || enc[i] == '_' || enc[i] == '-')) i++;
+        if (i == g || i >= enc.size() || enc[i] != '[') continue;
+        size_t close = enc.find(']', i + 1);
+        if (close == string::npos || close == i + 1 || close + 1 >= enc.size()) continue;
+        char next = enc[close + 1];
+        if (next != ';' && !isspace((unsigned char) next)) continue;
+        task = enc.substr(g, close + 1 - g);
+        return true;
+    }
+    return false;
+}
+
+// mtlt[]/tlt[] decomposition or "<abs> task -> method" line of the plan
+static bool hypothesisCandidate(const string& line, bool inTree, string& hypothesis) {
+    if (inTree && (has(line, "mtlt[]") || has(line, "tlt[]"))) {
+        size_t arrowPos = line.find("->");
+        if (arrowPos != string::npos) {
+            string afterArrow = trimmed(line.substr(arrowPos + 2));
+            // method encodings: "<<hypothesis-29;..." or "<hypothesis-29;..."
+            size_t skip = startsWith(afterArrow, "<<") ? 2 : (startsWith(afterArrow, "<") ? 1 : 0);
+            if (skip > 0) {
+                size_t end = afterArrow.find(';');
+                if (end != string::npos) {
+                    afterArrow = trimmed(afterArrow.substr(skip, end - skip));
+                }
+            }
+            if (!afterArrow.empty()) {
+                string candidate = trimmed(firstToken(afterArrow));
+                if (!candidate.empty() && !startsWith(candidate, "__")) {
+                    hypothesis = candidate;
+                    return true;
+                }
+            }
+        }
+    }
+
+    if (has(line, "<abs>") && has(line, "->")) {
+        size_t absPos = line.find("<abs>");
+        size_t arrowPos = line.find("->");
+        string between = trimmed(line.substr(absPos + 5, arrowPos - absPos - 5));
+        if (!startsWith(between, "__") && !startsWith(between, "_!") && !has(between, "[") && !between.empty()) {
+            hypothesis = between;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "TASK -> METHOD CHILD_ID ...", the text of a tree line after its id
+static string nodeText(const LogTreeNode& node) {
+    string text = node.task + " -> " + node.method;
+    for (int child : node.children) {
+        text += ' ';
+        text += to_string(child);
+    }
+    return text;
+}
+
+// line[pos..] is the text nodeText() gives for node
+static bool isNodeText(const string& line, size_t pos, const LogTreeNode& node) {
+    if (line.compare(pos, node.task.size(), node.task) != 0) return false;
+    pos += node.task.size();
+    if (line.compare(pos, 4, " -> ") != 0) return false;
+    pos += 4;
+    if (line.compare(pos, node.method.size(), node.method) != 0) return false;
+    pos += node.method.size();
+    for (int child : node.children) {
+        string id = to_string(child);
+        if (pos >= line.size() || line[pos] != ' ' || line.compare(pos + 1, id.size(), id) != 0) return false;
+        pos += 1 + id.size();
+    }
+    return pos == line.size();
+}
+
+void PlannerLogReader::readLine(const string& line) {
+    if (allSolutions && planState == Done && has(line, "==>")) {
+        endSolution();
+    }
+
+    bool planStep = false; // the line is the last plan step / tree node exactly as written
+    bool treeNode = false;
+
+    // search statistics, before the plan
+    if (planState == Before && startsWith(line, "- Generated ") && has(line, " search nodes")) {
+        result.generatedNodes = atol(line.c_str() + strlen("- Generated "));
+    }
+
+    // plan section
+    if (planState != Done) {
+        if (has(line, "==>")) {
+            planState = Inside;
+        } else if (has(line, "<==") || startsWith(line, "root ")) {
+            planState = Done;
+        } else if (planState == Inside && !has(line, "<abs>") && !has(line, "->")) {
+            size_t spacePos = line.find(' ');
+            if (spacePos != string::npos) {
+                size_t start = line.find_first_not_of(" \t", spacePos + 1);
+                size_t end = line.find_last_not_of(" \t\r\n");
+                if (start != string::npos && end != string::npos && end >= start) {
+                    result.plan.push_back(line.substr(start, end - start + 1));
+                    result.planSymbols.push_back(progression::SymbolTable::global().intern(result.plan.back()));
+                    int id;
+                    result.planStepIds.push_back(readInt(line, 0, id) ? id : -1);
+                    planStep = (start == spacePos + 1) && (end + 1 == line.size());
+                }
+            }
+        }
+    }
+
+    // decomposition tree
+    if (treeState != Done) {
+        if (has(line, "root 0")) {
+            treeState = Inside;
+        } else if (treeState == Inside && has(line, "<==")) {
+            treeState = Done;
+        } else if (treeState == Inside) {
+            size_t arrow = line.find(" -> ");
+            size_t firstSpace = line.find(' ');
+            if (arrow != string::npos && firstSpace != string::npos && arrow > firstSpace) {
+                LogTreeNode node;
+                readInt(line, 0, node.id);
+                node.task = line.substr(firstSpace + 1, arrow - firstSpace - 1);
+                node.taskSymbol = progression::SymbolTable::global().intern(node.task);
+                size_t methodStart = arrow + 4;
+                size_t methodEnd = line.find(' ', methodStart);
+                if (methodEnd == string::npos) methodEnd = line.length();
+                node.method = line.substr(methodStart, methodEnd - methodStart);
+                size_t c = methodEnd;
+                while (c < line.size()) {
+                    int child;
+                    if (readInt(line, c, child)) node.children.push_back(child);
+                    c = line.find(' ', c + 1);
+                }
+                treeNode = isNodeText(line, firstSpace + 1, node);
+                result.tree.push_back(move(node));
+            }
+        }
+    }
+
+    // explicit hypotheses, on trimmed lines
+    if (!hypothesisFound || splittedTree || has(line, "root 0")) {
+        string t = trimmed(line);
+        if (!hypothesisFound) {
+            hypothesisFound = hypothesisCandidate(t, hypothesisTree, result.hypothesis);
+            if (startsWith(t, "root ")) {
+                hypothesisTree = true;
+            } else if (startsWith(t, "<==") || startsWith(t, "===")) {
+                hypothesisTree = false;
+            }
+        }
+        if (has(t, "root 0")) {
+            splittedTree = true;
+        }
+        if (splittedTree) {
+            if (result.splittedHypothesis.empty() && (has(t, "mtlt[]") || has(t, "tlt[]") || has(t, "__top[] ->"))) {
+                size_t arrowPos = t.find("->");
+                if (arrowPos != string::npos) {
+                    string afterArrow = trimmed(t.substr(arrowPos + 2));
+                    if (!afterArrow.empty()) {
+                        result.splittedHypothesis = trimmed(firstToken(afterArrow));
+                    }
+                }
+            }
+            if (has(t, "_splitted")) {
+                result.splittedLines.push_back(t);
+            }
+        }
+    }
+
+    // top-level task wrapper
+    if (!topDone) {
+        // numbered "ID TEXT" line, lines with a '\r' are not indexed
+        if (!line.empty() && isdigit((unsigned char) line[0]) && line.find('\r') == string::npos) {
+            size_t firstSpace = line.find(' ');
+            if (firstSpace != string::npos && line.find_first_not_of("0123456789") == firstSpace) {
+                int id;
+                if (readInt(line, 0, id)) {
+                    if (planStep) {
+                        numbered[id] = {PlanStep, result.plan.size() - 1};
+                    } else if (treeNode) {
+                        numbered[id] = {TreeNode, result.tree.size() - 1};
+                    } else {
+                        numbered[id] = {OtherLine, otherLines.size()};
+                        otherLines.push_back(line.substr(firstSpace + 1));
+                    }
+                }
+            }
+        }
+        if (has(line, "__top[] ->")) {
+            topDone = true;
+            result.hasTopLine = readInt(line, line.find_last_of(' ') + 1, topId) && (topId != -1);
+        }
+    }
+
+    lastLine = line;
+}
+
+void PlannerLogReader::feed(const char* data, size_t size) {
+    const char* end = data + size;
+    while (data < end) {
+        const char* eol = static_cast<const char*>(memchr(data, '\n', end - data));
+        if (eol == nullptr) {
+            partial.append(data, end);
+            return;
+        }
+        if (partial.empty()) {
+            readLine(string(data, eol));
+        } else {
+            partial.append(data, eol);
+            readLine(partial);
+            partial.clear();
+        }
+        data = eol + 1;
+    }
+}
+
+bool PlannerLogReader::numberedText(int id, string& text) const {
+    auto line = numbered.find(id);
+    if (line == numbered.end()) return false;
+    switch (line->second.source) {
+        case PlanStep: text = result.plan[line->second.index]; break;
+        case TreeNode: text = nodeText(result.tree[line->second.index]); break;
+        case OtherLine: text = otherLines[line->second.index]; break;
+    }
+    return true;
+}
+
+void PlannerLogReader::findTopHypothesis() {
+    string encoding;
+    if (result.hasTopLine && numberedText(topId, encoding)) {
+        if (!findGroundedTask(encoding, result.topHypothesis)) {
+            // e.g. "13 tlt[] -> m-tlt-plow-road 2329": the hypothesis is the child line
+            size_t digits = encoding.find_last_not_of("0123456789") + 1;
+            int child;
+            if (digits < encoding.size() && readInt(encoding, digits, child)) {
+                numberedText(child, result.topHypothesis);
+            }
+        }
+    }
+    numbered.clear();
+    otherLines.clear();
+}
+
+// the next solution starts, the state of all sections is reset
+void PlannerLogReader::endSolution() {
+    findTopHypothesis();
+    solutions.push_back(move(result));
+    result = ParsedLog();
+    planState = Before;
+    treeState = Before;
+    hypothesisTree = false;
+    hypothesisFound = false;
+    splittedTree = false;
+    topDone = false;
+    topId = -1;
+}
+
+ParsedLog PlannerLogReader::finish() {
+    if (!partial.empty()) {
+        readLine(partial);
+        partial.clear();
+    }
+    result.provenUnsolvable = has(lastLine, "Status: Proven unsolvable");
+    findTopHypothesis();
+    return move(result);
+}
+
+vector<ParsedLog> PlannerLogReader::finishAll() {
+    ParsedLog last = finish();
+    if (!solutions.empty()) {
+        // the last block is a solution as well (its "==>" ended the one before), a
+        // final "Proven unsolvable" only says that the planner ran out of further ones
+        last.provenUnsolvable = false;
+    }
+    solutions.push_back(move(last));
+    return move(solutions);
+}
+
+ParsedLog parsePlannerLog(const string& text) {
+    TRACE_SCOPE("log_parse");
+    TRACE_ARG("bytes", text.size());
+    PlannerLogReader reader;
+    reader.feed(text.data(), text.size());
+    return reader.finish();
+}
+
+ParsedLog parsePlannerLog(istream& log) {
+    TRACE_SCOPE("log_parse");
+    PlannerLogReader reader;
+    char buffer[1 << 16];
+    while (log.read(buffer, sizeof(buffer)) || log.gcount() > 0) {
+        reader.feed(buffer, log.gcount());
+    }
+    return reader.finish();
+}
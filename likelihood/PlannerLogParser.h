@@ -0,0 +1,106 @@
+/**
+ * Single-pass reader for pplanner logs
+ *
+ * A log is read once and split into what the tools use: the plan, the
+ * decomposition tree, the planner status and the hypothesis candidates of the
+ * posterior tools (see posterior/PlannerLog.h). The reader only compares
+ * fixed substrings, lines are scanned in place without regular expressions.
+ *
+ * PlannerLogReader takes the log in pieces as the planner writes it (e.g.
+ * from a pipe, see runToolPiped()), so the log needs neither a file nor to be
+ * held in memory as a whole. Action and task names are interned while reading
+ * (htnModel/SymbolTable.h), so they are resolved against each model by symbol
+ * id.
+ *
+ * A planner that keeps searching after its first solution prints one
+ * "==>" ... "<==" block per solution. With allSolutions, finishAll() returns
+ * one ParsedLog per block instead of reading everything into the first one.
+ */
+
+#ifndef PLANNERLOGPARSER_H_
+#define PLANNERLOGPARSER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../htnModel/SymbolTable.h"
+
+using namespace std;
+
+// decomposition line "ID TASK -> METHOD CHILD_ID ..."
+struct LogTreeNode {
+    int id = -1;
+    string task;            // text between the id and " -> "
+    int taskSymbol = -1;    // task interned in the SymbolTable
+    string method;          // first token after " -> "
+    vector<int> children;   // ids of the subtasks
+};
+
+struct ParsedLog {
+    vector<string> plan;            // actions of the plan section ("==>" ... "root "/"<=="), in order
+    vector<int> planStepIds;        // their ids, -1 if the line has none
+    vector<int> planSymbols;        // the actions interned in the SymbolTable
+    vector<LogTreeNode> tree;       // decomposition lines ("root 0" ... "<=="), in log order
+    bool provenUnsolvable = false;  // the last line reports "Status: Proven unsolvable"
+    long generatedNodes = -1;       // "- Generated N search nodes" of the search, -1 without it
+
+    // explicit hypothesis domains (kitchen)
+    string hypothesis;              // hypothesis chosen for mtlt[]/tlt[]
+    string splittedHypothesis;      // first method below mtlt[]/tlt[]/__top[] in the tree
+    vector<string> splittedLines;   // tree lines of splitted methods, trimmed
+
+    // top-level task wrapper domains (Monroe)
+    bool hasTopLine = false;        // the log contains a "__top[] ->" line
+    string topHypothesis;           // grounded task below __top[] (or the child line)
+};
+
+class PlannerLogReader {
+public:
+    explicit PlannerLogReader(bool allSolutions = false) : allSolutions(allSolutions) {}
+
+    // the next size bytes of the log, lines may be split between calls
+    void feed(const char* data, size_t size);
+    // ends the log (a last line without '\n' is read, too) and hands out the
+    // result, the reader is used up afterwards
+    ParsedLog finish();
+    // finish() for all solutions in log order, the status at the end of the log
+    // only applies to a last block without a plan
+    vector<ParsedLog> finishAll();
+
+private:
+    enum sectionState {Before, Inside, Done};
+
+    bool allSolutions;
+    vector<ParsedLog> solutions;    // the blocks before the current one (allSolutions)
+    ParsedLog result;
+    string partial;                 // incomplete last line of the data fed so far
+    string lastLine;
+    sectionState planState = Before;
+    sectionState treeState = Before;
+    bool hypothesisTree = false;
+    bool hypothesisFound = false;
+    bool splittedTree = false;
+    bool topDone = false;
+    int topId = -1;
+
+    // numbered "ID TEXT" lines up to the __top[] line, the last one of each id;
+    // most of them are a plan step or a tree node and their text is not copied
+    enum lineSource {PlanStep, TreeNode, OtherLine};
+    struct NumberedLine {
+        lineSource source;
+        size_t index;               // into result.plan, result.tree or otherLines
+    };
+    unordered_map<int, NumberedLine> numbered;
+    vector<string> otherLines;      // text after the id of the remaining numbered lines
+
+    void readLine(const string& line);
+    bool numberedText(int id, string& text) const;
+    void findTopHypothesis();
+    void endSolution();
+};
+
+ParsedLog parsePlannerLog(const string& text);
+ParsedLog parsePlannerLog(istream& log);
+
+#endif /* PLANNERLOGPARSER_H_ */
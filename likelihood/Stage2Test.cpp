@@ -0,0 +1,128 @@
+/**
+ * Stage II of the bitset state against the set based implementation it
+ * replaced, on random models, plans and ordering relations.
+ * Returns nonzero if a case disagrees.
+ */
+
+#include <random>
+#include <cmath>
+#include "NormalizedLikelihood.h"
+
+// Stage II as it was computed before the bitset state: the state is a set of
+// facts and the ordering constraints are scanned as pairs for every action
+static double referenceStage2LogProbability(Model* htn, const vector<int>& plan,
+                                            const set<pair<int,int>>& orderingConstraints) {
+    unordered_set<int> currentState;
+    for (int i = 0; i < htn->s0Size; i++) {
+        currentState.insert(htn->s0List[i]);
+    }
+    set<int> remaining;
+    for (int taskId : plan) {
+        if (taskId >= 0 && taskId < htn->numActions) {
+            remaining.insert(taskId);
+        }
+    }
+
+    double logProb = 0.0;
+    for (int selectedAction : plan) {
+        int applicableCount = 0;
+        for (int taskId : remaining) {
+            bool hasUnexecutedPredecessor = false;
+            for (const auto& ord : orderingConstraints) {
+                if (ord.second == taskId && remaining.find(ord.first) != remaining.end()) {
+                    hasUnexecutedPredecessor = true;
+                    break;
+                }
+            }
+            if (!hasUnexecutedPredecessor && isApplicable(htn, currentState, taskId)) {
+                applicableCount++;
+            }
+        }
+        if (applicableCount == 0) applicableCount = 1;
+        logProb += log(1.0 / applicableCount);
+
+        applyAction(htn, currentState, selectedAction);
+        remaining.erase(selectedAction);
+    }
+    return logProb;
+}
+
+static int* randomList(mt19937& rng, int maxSize, int numFacts, int& size) {
+    set<int> facts;
+    int n = uniform_int_distribution<int>(0, maxSize)(rng);
+    for (int i = 0; i < n; i++) {
+        facts.insert(uniform_int_distribution<int>(0, numFacts - 1)(rng));
+    }
+    int* list = new int[facts.size()];
+    copy(facts.begin(), facts.end(), list);
+    size = facts.size();
+    return list;
+}
+
+// a classical model with random preconditions and effects, it is not deleted
+// since ~Model() expects the arrays that read() sets up besides these
+static Model* randomModel(mt19937& rng, int numActions, int numFacts) {
+    Model* htn = new Model();
+    htn->numStateBits = numFacts;
+    htn->numActions = numActions;
+    htn->numTasks = numActions;
+    htn->taskNames = new string[max(numActions, 1)];
+    htn->numPrecs = new int[numActions];
+    htn->numAdds = new int[numActions];
+    htn->numDels = new int[numActions];
+    htn->precLists = new int*[numActions];
+    htn->addLists = new int*[numActions];
+    htn->delLists = new int*[numActions];
+    for (int a = 0; a < numActions; a++) {
+        htn->taskNames[a] = "a" + to_string(a);
+        htn->precLists[a] = randomList(rng, 3, numFacts, htn->numPrecs[a]);
+        htn->addLists[a] = randomList(rng, 3, numFacts, htn->numAdds[a]);
+        htn->delLists[a] = randomList(rng, 2, numFacts, htn->numDels[a]);
+    }
+    htn->s0List = randomList(rng, numFacts, numFacts, htn->s0Size);
+    return htn;
+}
+
+int main() {
+    mt19937 rng(20240611);
+    int failures = 0;
+    int cases = 0;
+
+    for (int run = 0; run < 300; run++) {
+        // more than 64 facts and tasks in some runs, so the rows span several words
+        int numActions = uniform_int_distribution<int>(1, (run % 3 == 0) ? 90 : 12)(rng);
+        int numFacts = uniform_int_distribution<int>(1, (run % 2 == 0) ? 140 : 20)(rng);
+        Model* htn = randomModel(rng, numActions, numFacts);
+
+        for (int p = 0; p < 5; p++) {
+            vector<int> plan(uniform_int_distribution<int>(0, 2 * numActions)(rng));
+            for (int& a : plan) {
+                a = uniform_int_distribution<int>(0, numActions - 1)(rng);
+            }
+            // the orderings may contain cycles and tasks that are not in the plan
+            vector<pair<int,int>> orderings(uniform_int_distribution<int>(0, 3 * numActions)(rng));
+            for (auto& ord : orderings) {
+                ord.first = uniform_int_distribution<int>(0, numActions + 4)(rng);
+                ord.second = uniform_int_distribution<int>(0, numActions + 4)(rng);
+            }
+            OrderingRelation relation(orderings);
+            if (p % 2 == 0) {
+                relation.close();
+            }
+
+            double expected = referenceStage2LogProbability(htn, plan, relation.pairs());
+            double actual = computeStage2LogProbability(htn, plan, relation, false);
+            double linear = computeStage2Probability(htn, plan, relation.pairs(), false);
+            cases++;
+            if (fabs(expected - actual) > 1e-9 * max(1.0, fabs(expected))
+                    || fabs(exp(expected) - linear) > 1e-12 * max(1.0, exp(expected))) {
+                failures++;
+                cerr << "run " << run << " plan " << p << ": expected log P = " << expected
+                     << ", got " << actual << " (linear " << linear << ")" << endl;
+            }
+        }
+    }
+
+    cout << "Stage II: " << (cases - failures) << "/" << cases << " cases agree" << endl;
+    return failures == 0 ? 0 : 1;
+}
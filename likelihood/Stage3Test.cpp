@@ -0,0 +1,142 @@
+/**
+ * Stage III under partial observability against the table based alignment
+ * it replaced, on random observation sequences and plans, and the Stage III
+ * that serve updates per observation against the one of a fresh run.
+ * Returns nonzero if a case disagrees.
+ */
+
+#include <random>
+#include <cmath>
+#include "NormalizedLikelihood.h"
+
+// dp[i][j] = P(ô_{1:i} | π_{1:j}) as a full table, as it was computed before
+// the single column forward pass
+static double referenceAlignmentPartialObs(const vector<int>& observations,
+                                           const vector<int>& planPrefix, double pDet) {
+    int m = observations.size();
+    int n = planPrefix.size();
+    if (m > n) return 0.0;
+
+    vector<vector<double>> dp(m + 1, vector<double>(n + 1, 0.0));
+    dp[0][0] = 1.0;
+    for (int j = 1; j <= n; j++) {
+        dp[0][j] = dp[0][j-1] * (1 - pDet);
+    }
+    for (int i = 1; i <= m; i++) {
+        for (int j = i; j <= n; j++) {
+            double match = (observations[i-1] == planPrefix[j-1]) ? dp[i-1][j-1] * pDet : 0.0;
+            dp[i][j] = match + dp[i][j-1] * (1 - pDet);
+        }
+    }
+    return dp[m][n];
+}
+
+// the marginal over the prefix lengths, one table per prefix
+static double referenceStage3PartialObs(const vector<int>& observations,
+                                        const vector<int>& plan, double pDet) {
+    double total = 0.0;
+    for (size_t t = observations.size(); t <= plan.size(); t++) {
+        vector<int> planPrefix(plan.begin(), plan.begin() + t);
+        total += progressPrior(t, plan.size()) * referenceAlignmentPartialObs(observations, planPrefix, pDet);
+    }
+    return total;
+}
+
+static vector<int> randomSequence(mt19937& rng, int maxLength, int numActions) {
+    vector<int> sequence(uniform_int_distribution<int>(0, maxLength)(rng));
+    for (int& a : sequence) {
+        a = uniform_int_distribution<int>(0, numActions - 1)(rng);
+    }
+    return sequence;
+}
+
+static bool close(double expected, double actual) {
+    return fabs(expected - actual) <= 1e-12 * max(fabs(expected), 1e-300);
+}
+
+static bool closeLog(double expected, double actual) {
+    if (expected == -INFINITY || actual == -INFINITY) return expected == actual;
+    return fabs(expected - actual) <= 1e-9 * max(fabs(expected), 1.0);
+}
+
+int main() {
+    mt19937 rng(20240613);
+    int failures = 0;
+    int cases = 0;
+
+    for (int run = 0; run < 2000; run++) {
+        // few distinct actions, so that observations match several plan steps
+        int numActions = uniform_int_distribution<int>(1, 4)(rng);
+        vector<int> plan = randomSequence(rng, 40, numActions);
+        // mostly subsequences of the plan, which the alignment has to find
+        vector<int> observations;
+        if (run % 4 == 0) {
+            observations = randomSequence(rng, 10, numActions);
+        } else {
+            for (int a : plan) {
+                if (uniform_int_distribution<int>(0, 2)(rng) == 0) {
+                    observations.push_back(a);
+                }
+            }
+        }
+        double pDet = uniform_real_distribution<double>(0.05, 0.95)(rng);
+
+        double expectedAlignment = referenceAlignmentPartialObs(observations, plan, pDet);
+        double actualAlignment = alignmentLikelihoodPartialObs(observations, plan, pDet);
+        double expected = referenceStage3PartialObs(observations, plan, pDet);
+        double actual = computeStage3Probability(observations, plan, false, pDet, nullptr, false);
+        double actualLog = computeStage3LogProbability(observations, plan, false, pDet, nullptr, false);
+        cases++;
+        if (!close(expectedAlignment, actualAlignment) || !close(expected, actual)
+                || !close(expected, exp(actualLog))) {
+            failures++;
+            cerr << "run " << run << ": expected P(ô | π) = " << expected << ", got " << actual
+                 << " (alignment " << expectedAlignment << " / " << actualAlignment << ")" << endl;
+        }
+    }
+
+    // serve extends one IncrementalStage3 per plan by the plan's own steps up
+    // to the observations so far (PosteriorDriver::extendServedScores()), a
+    // run with that num_obs scores stage3Observations() of the plan from scratch
+    for (int run = 0; run < 500; run++) {
+        int numActions = uniform_int_distribution<int>(1, 4)(rng);
+        vector<int> plan = randomSequence(rng, 30, numActions);
+        bool fullObservability = (run % 2 == 0);
+        double pDet = uniform_real_distribution<double>(0.05, 0.95)(rng);
+
+        IncrementalStage3 served(plan, fullObservability, pDet);
+        int numObservations = 0;
+        while (numObservations <= (int) plan.size() + 2) {
+            int n = stage3Observations(plan, numObservations).size();
+            while (served.numObservations() < n) {
+                served.addObservation(plan[served.numObservations()]);
+            }
+            double expected = computeStage3LogProbability(stage3Observations(plan, numObservations), plan,
+                                                          fullObservability, pDet, nullptr, false);
+            cases++;
+            if (!closeLog(expected, served.logProbability())) {
+                failures++;
+                cerr << "served run " << run << " after " << numObservations << " observations: expected log P = "
+                     << expected << ", got " << served.logProbability() << endl;
+            }
+            numObservations += uniform_int_distribution<int>(1, 3)(rng);
+        }
+
+        // the consistency of a plan with observations other than its own steps
+        vector<int> observations = randomSequence(rng, 8, numActions);
+        IncrementalStage3 filter(plan, fullObservability, pDet);
+        for (int o : observations) {
+            filter.addObservation(o);
+        }
+        double expected = computeStage3LogProbability(observations, plan, fullObservability, pDet, nullptr, false);
+        cases++;
+        if (!closeLog(expected, filter.logProbability()) || filter.consistent() != (expected > -INFINITY)) {
+            failures++;
+            cerr << "filter run " << run << ": expected log P = " << expected
+                 << ", got " << filter.logProbability() << endl;
+        }
+    }
+
+    cout << "Stage III: " << (cases - failures) << "/" << cases << " cases agree" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/**
+ * Persistent cache of the solved baseline problems, see BaselineCache.h
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <sys/stat.h>
+#include "BaselineCache.h"
+#include "Subprocess.h"
+#include "TextUtil.h"
+
+void BaselineCache::open(const string& dir, const string& toolDir) {
+    this->dir = dir;
+    toolStamp.clear();
+    if (this->dir.empty()) {
+        return;
+    }
+    if (this->dir.back() != '/') {
+        this->dir += "/";
+    }
+    if (!makeDirectories(this->dir)) {
+        cerr << "Warning: Cannot create baseline cache directory: " << this->dir << endl;
+        this->dir = "";
+        return;
+    }
+    // a rebuilt tool may ground or plan differently
+    toolStamp = ::toolStamp(toolDir, {"pandaPIparser", "pandaPIgrounder", "pplanner"});
+}
+
+bool BaselineCache::enabled() const {
+    return !dir.empty();
+}
+
+string BaselineCache::key(const string& domainFile, const string& problemFile) const {
+    string domain, problem;
+    if (!readTextFile(domainFile, domain) || !readTextFile(problemFile, problem)) {
+        return "";
+    }
+    uint64_t hash = hashText(toolStamp);
+    hash = hashText(to_string(domain.size()) + "\n" + domain, hash);
+    hash = hashText(to_string(problem.size()) + "\n" + problem, hash);
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash);
+    return name;
+}
+
+bool BaselineCache::lookup(const string& key, string& psas, ParsedLog& log) const {
+    if (!enabled() || key.empty()) {
+        return false;
+    }
+    ifstream in(dir + key + ".log");
+    if (!in.is_open()) {
+        return false;
+    }
+    struct stat st;
+    if (stat((dir + key + ".psas").c_str(), &st) != 0) {
+        return false;
+    }
+    log = parsePlannerLog(in);
+    if (log.plan.empty()) {
+        return false;
+    }
+    psas = dir + key + ".psas";
+    return true;
+}
+
+bool BaselineCache::store(const string& key, const string& psas, const string& logFile) const {
+    if (!enabled() || key.empty()) {
+        return false;
+    }
+    return publishFile(psas, dir + key + ".psas") && publishFile(logFile, dir + key + ".log");
+}
@@ -0,0 +1,47 @@
+/**
+ * Persistent cache of the solved baseline problems
+ *
+ * The baseline of a hypothesis is the original problem with the hypothesis as
+ * its goal, it does not depend on the observations. Its grounded model and
+ * planner log are stored under a key computed from the content of the domain
+ * and the baseline problem (and the identity of the tools), so a hypothesis
+ * that comes up again for another number of observations, in another sweep or
+ * in a concurrent job sharing the directory is neither grounded nor solved
+ * again.
+ *
+ * Entries are published with a hard link and a rename (publishFile): <key>.psas
+ * first, then <key>.log, which marks the entry as complete. Concurrent jobs computing the same entry
+ * write the same content, whichever rename comes last wins.
+ *
+ * Only the solutions are cached; the baseline Stage II is computed with the
+ * ordering constraints of the observation tree as well, so the likelihood
+ * itself is computed for every pair.
+ */
+
+#ifndef BASELINECACHE_H_
+#define BASELINECACHE_H_
+
+#include <string>
+#include "../likelihood/PlannerLogParser.h"
+
+using namespace std;
+
+class BaselineCache {
+public:
+    // the cache is disabled until it is opened with a directory
+    void open(const string& dir, const string& toolDir);
+
+    bool enabled() const;
+    // empty if one of the files cannot be read
+    string key(const string& domainFile, const string& problemFile) const;
+    // the cached grounded model and the parsed planner log of key
+    bool lookup(const string& key, string& psas, ParsedLog& log) const;
+    // links (or copies) the grounded model and the planner log into the cache
+    bool store(const string& key, const string& psas, const string& logFile) const;
+
+private:
+    string dir;
+    string toolStamp;               // sizes and modification times of the tools
+};
+
+#endif /* BASELINECACHE_H_ */
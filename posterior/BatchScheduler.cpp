@@ -0,0 +1,334 @@
+/**
+ * Batch runs of the posterior driver for experiment sweeps, see BatchScheduler.h
+ */
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <csignal>
+#include <map>
+#include "BatchScheduler.h"
+#include "TextUtil.h"
+
+static string baseName(const string& path) {
+    size_t slash = path.find_last_of('/');
+    string name = (slash == string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+bool readManifest(const string& manifestFile, vector<BatchJob>& jobs) {
+    ifstream file(manifestFile);
+    if (!file.is_open()) {
+        cerr << "Error: Cannot open manifest file: " << manifestFile << endl;
+        return false;
+    }
+
+    set<string> names;
+    string line;
+    int lineNo = 0;
+    while (getline(file, line)) {
+        lineNo++;
+        line = trim(line);
+        if (line.empty() || startsWith(line, "#")) continue;
+
+        istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.domainFile >> job.problemFile >> job.observationFile >> job.numObs >> job.kIterations)) {
+            cerr << "Error: Malformed manifest line " << lineNo << ": " << line << endl;
+            return false;
+        }
+        if (!(fields >> job.name)) {
+            job.name = baseName(job.problemFile) + "_obs_" + to_string(job.numObs);
+        }
+        if (!names.insert(job.name).second) {
+            cerr << "Error: Duplicate job name in manifest line " << lineNo << ": " << job.name << endl;
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+int shardOf(const BatchJob& job, int numShards) {
+    return (int) (hashText(job.problemFile + "\n" + to_string(job.numObs)) % (uint64_t) max(numShards, 1));
+}
+
+vector<BatchJob> shardJobs(const vector<BatchJob>& jobs, int shard, int numShards) {
+    vector<BatchJob> selected;
+    for (const BatchJob& job : jobs) {
+        if (shardOf(job, numShards) == shard) {
+            selected.push_back(job);
+        }
+    }
+    return selected;
+}
+
+BatchScheduler::BatchScheduler(const vector<BatchJob>& jobs, const BatchOptions& options)
+        : jobs(jobs), options(options), queues(max(options.workers, 1)), queueLocks(max(options.workers, 1)) {
+    if (this->options.resultsDir.empty()) {
+        this->options.resultsDir = ".";
+    }
+    if (this->options.resultsDir.back() != '/') {
+        this->options.resultsDir += "/";
+    }
+}
+
+string BatchScheduler::checkpointFile() const {
+    return options.resultsDir + "batch_checkpoint.txt";
+}
+
+set<string> BatchScheduler::readCheckpoint() const {
+    set<string> done;
+    ifstream file(checkpointFile());
+    string line;
+    while (getline(file, line)) {
+        vector<string> fields = split(line, '\t');
+        // a line cut off by an interrupted run has fewer fields; failed and timed out jobs run again
+        if (fields.size() >= 4 && fields[1] == "ok") {
+            done.insert(fields[0]);
+        }
+    }
+    return done;
+}
+
+// ============================================================================
+// SCHEDULING
+// ============================================================================
+
+bool BatchScheduler::nextJob(int worker, int& job) {
+    {
+        lock_guard<mutex> guard(queueLocks[worker]);
+        if (!queues[worker].empty()) {
+            job = queues[worker].back();
+            queues[worker].pop_back();
+            return true;
+        }
+    }
+    // steal the oldest job of another worker
+    int numWorkers = queues.size();
+    for (int i = 1; i < numWorkers; i++) {
+        int victim = (worker + i) % numWorkers;
+        lock_guard<mutex> guard(queueLocks[victim]);
+        if (!queues[victim].empty()) {
+            job = queues[victim].front();
+            queues[victim].pop_front();
+            return true;
+        }
+    }
+    // jobs are only added before the workers start, so all queues stay empty
+    return false;
+}
+
+void BatchScheduler::work(int worker) {
+    int job;
+    while ((interruptSignal() == 0) && nextJob(worker, job)) {
+        runJob(worker, job);
+    }
+}
+
+void BatchScheduler::runJob(int worker, int job) {
+    const BatchJob& j = jobs[job];
+    string workDir = options.resultsDir + j.name;
+    makeDirectories(workDir);
+
+    vector<string> args = {options.driver, j.domainFile, j.problemFile, j.observationFile,
+                           to_string(j.numObs), to_string(j.kIterations), workDir};
+    if (!options.cacheDir.empty()) {
+        // before the passed options, so that e.g. --no-model-cache still applies
+        args.insert(args.end(), {"--model-cache", options.cacheDir + "/model_cache",
+                                 "--baseline-cache", options.cacheDir + "/baseline_cache",
+                                 "--grounding-cache", options.cacheDir + "/grounding_cache"});
+    }
+    args.insert(args.end(), options.driverArgs.begin(), options.driverArgs.end());
+
+    {
+        lock_guard<mutex> guard(checkpointLock);
+        cout << "[Worker " << worker << "] Starting " << j.name << endl;
+    }
+    ToolUsage usage = runToolLimited(args, workDir + "/run.log", options.limits);
+    if (usage.interrupted) {
+        // not checkpointed, the job starts again when the batch is resumed
+        lock_guard<mutex> guard(checkpointLock);
+        cout << "[Worker " << worker << "] " << j.name << " -> interrupted" << endl;
+        return;
+    }
+
+    string status;
+    if (usage.timedOut) {
+        status = "timeout";
+    } else if (usage.status == 0) {
+        status = "ok";
+    } else {
+        status = "failed(" + to_string(usage.status) + ")";
+    }
+
+    lock_guard<mutex> guard(checkpointLock);
+    if (status != "ok") {
+        numFailed++;
+    }
+    checkpoint << j.name << "\t" << status << "\t" << fixed << setprecision(3) << usage.seconds
+               << "\t" << usage.maxRssKB << endl;
+    cout << "[Worker " << worker << "] " << j.name << " -> " << status << " ("
+         << fixed << setprecision(3) << usage.seconds << "s, " << usage.maxRssKB << " KB)" << endl;
+}
+
+int BatchScheduler::run() {
+    if (!makeDirectories(options.resultsDir)) {
+        cerr << "Error: Cannot create results directory: " << options.resultsDir << endl;
+        return (int) jobs.size();
+    }
+
+    set<string> done = readCheckpoint();
+    int numWorkers = queues.size();
+    int numQueued = 0;
+    for (int i = 0; i < (int) jobs.size(); i++) {
+        if (done.find(jobs[i].name) != done.end()) continue;
+        // the owner works from the back, so deal in reverse to start with the first jobs
+        queues[numQueued % numWorkers].push_front(i);
+        numQueued++;
+    }
+    cout << "Batch: " << jobs.size() << " jobs, " << (jobs.size() - numQueued) << " already done, "
+         << numWorkers << " workers" << endl;
+
+    checkpoint.open(checkpointFile(), ios::app);
+    if (!checkpoint.is_open()) {
+        cerr << "Error: Cannot write checkpoint file: " << checkpointFile() << endl;
+        return numQueued;
+    }
+
+    // the jobs run in their own process groups, see runToolLimited
+    installInterruptHandler();
+    numFailed = 0;
+    vector<thread> workers;
+    for (int w = 0; w < numWorkers; w++) {
+        workers.emplace_back(&BatchScheduler::work, this, w);
+    }
+    for (thread& t : workers) {
+        t.join();
+    }
+    checkpoint.close();
+
+    int sig = interruptSignal();
+    if (sig != 0) {
+        cout << "Batch interrupted, the unfinished jobs run again when it is started again" << endl;
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+    cout << "Batch done: " << (numQueued - numFailed) << " ok, " << numFailed << " failed or timed out" << endl;
+    return numFailed;
+}
+
+// ============================================================================
+// MERGING SHARDS
+// ============================================================================
+
+int mergeShards(const vector<string>& shardDirs, const string& reportDir) {
+    struct MergedJob {
+        string shardDir;
+        vector<string> fields;      // of the checkpoint line
+        vector<string> posteriors;  // "hypothesis likelihood posterior", by posterior
+    };
+    map<string, MergedJob> merged;
+    int numShards = 0;
+    for (string dir : shardDirs) {
+        if (dir.empty() || dir.back() != '/') {
+            dir += "/";
+        }
+        ifstream file(dir + "batch_checkpoint.txt");
+        if (!file.is_open()) {
+            cerr << "Warning: No batch_checkpoint.txt in shard " << dir << endl;
+            continue;
+        }
+        numShards++;
+        string line;
+        while (getline(file, line)) {
+            vector<string> fields = split(line, '\t');
+            if (fields.size() < 4) continue;
+            auto it = merged.find(fields[0]);
+            if (it != merged.end() && it->second.shardDir != dir) {
+                cerr << "Warning: Job " << fields[0] << " is in shards " << it->second.shardDir << " and " << dir
+                     << ", using the latter" << endl;
+            }
+            // a job run again in the same shard is appended, the last line counts
+            merged[fields[0]] = {dir, fields, {}};
+        }
+    }
+    if (numShards == 0) {
+        cerr << "Error: No shard to merge" << endl;
+        return -1;
+    }
+
+    int numOk = 0, numFailed = 0, numMissing = 0;
+    double totalSeconds = 0.0;
+    long maxRssKB = 0;
+    for (auto& entry : merged) {
+        MergedJob& job = entry.second;
+        totalSeconds += atof(job.fields[2].c_str());
+        maxRssKB = max(maxRssKB, atol(job.fields[3].c_str()));
+        if (job.fields[1] != "ok") {
+            numFailed++;
+            continue;
+        }
+        ifstream file(job.shardDir + entry.first + "/posteriors.txt");
+        string line;
+        while (getline(file, line)) {
+            line = trim(line);
+            if (!line.empty() && line[0] != '#') {
+                job.posteriors.push_back(line);
+            }
+        }
+        if (job.posteriors.empty()) {
+            cerr << "Warning: No posteriors of job " << entry.first << " in " << job.shardDir << endl;
+            numMissing++;
+        } else {
+            numOk++;
+        }
+    }
+
+    if (!makeDirectories(reportDir)) {
+        cerr << "Error: Cannot create report directory: " << reportDir << endl;
+        return -1;
+    }
+    string dir = (reportDir.back() == '/') ? reportDir : reportDir + "/";
+    ofstream checkpoint(dir + "batch_checkpoint.txt");
+    ofstream posteriors(dir + "posteriors.txt");
+    ofstream report(dir + "report.txt");
+    if (!checkpoint.is_open() || !posteriors.is_open() || !report.is_open()) {
+        cerr << "Error: Cannot write the report to " << dir << endl;
+        return -1;
+    }
+
+    posteriors << "# Posteriors of " << merged.size() << " jobs merged from " << numShards << " shards" << endl;
+    posteriors << "# Format: job hypothesis_name likelihood posterior" << endl;
+    report << "============================================================" << endl;
+    report << "Merged Batch Report" << endl;
+    report << "============================================================" << endl;
+    report << "Shards:            " << numShards << endl;
+    report << "Jobs:              " << merged.size() << " (" << numOk << " ok, " << numFailed
+           << " failed or timed out, " << numMissing << " without posteriors)" << endl;
+    report << "Total job time:    " << fixed << setprecision(3) << totalSeconds << " s" << endl;
+    report << "Max peak RSS:      " << maxRssKB << " KB" << endl;
+    report << endl;
+    report << "# job status seconds peak_rss_kb top_hypothesis posterior shard" << endl;
+    for (const auto& entry : merged) {
+        const MergedJob& job = entry.second;
+        for (size_t i = 0; i < job.fields.size(); i++) {
+            checkpoint << (i ? "\t" : "") << job.fields[i];
+        }
+        checkpoint << endl;
+        for (const string& line : job.posteriors) {
+            posteriors << entry.first << " " << line << endl;
+        }
+        // the posteriors are sorted, the first line is the best hypothesis
+        vector<string> top = job.posteriors.empty() ? vector<string>() : split(job.posteriors.front(), ' ');
+        report << entry.first << " " << job.fields[1] << " " << job.fields[2] << " " << job.fields[3] << " "
+               << ((top.size() >= 3) ? top[0] + " " + top[2] : "- -") << " " << job.shardDir << endl;
+    }
+
+    cout << "Merged " << merged.size() << " jobs from " << numShards << " shards into " << dir << endl;
+    return numFailed + numMissing;
+}
@@ -0,0 +1,98 @@
+/**
+ * Batch runs of the posterior driver for experiment sweeps
+ *
+ * A manifest lists one job per line:
+ *   <domain_file> <problem_file> <observation_file> <num_obs> <k_iterations> [name]
+ * Empty lines and lines starting with '#' are ignored. Without a name, the job
+ * is called <problem>_obs_<num_obs>.
+ *
+ * Every job runs the single-problem driver as a child process in
+ * <results_dir>/<name>, with its own time and memory budget. The jobs are
+ * dealt round-robin to per-worker deques; a worker takes jobs from the back
+ * of its own deque and steals from the front of the others once it runs dry,
+ * so a slow job does not keep cores idle while other jobs wait behind it.
+ *
+ * Finished jobs are appended to <results_dir>/batch_checkpoint.txt; jobs
+ * listed there as ok are skipped when the batch is started again, failed and
+ * timed out ones run again (their new line is appended and counts). SIGINT
+ * and SIGTERM kill the running jobs with all their tools before the
+ * scheduler exits, these jobs are not listed.
+ *
+ * A sweep too big for one machine is split into shards: shard i of n runs
+ * the jobs whose (problem, num_obs) hash to i, which is the same on every
+ * machine reading the same manifest, each shard into its own results
+ * directory. The jobs of a shard can share a node-local model, baseline and
+ * grounding cache. mergeShards combines the checkpoints and posteriors.txt of
+ * the shard directories into one report; the shards only have to see the
+ * same manifest and input files (shared file system, or copies via ssh).
+ */
+
+#ifndef BATCHSCHEDULER_H_
+#define BATCHSCHEDULER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include "Subprocess.h"
+
+using namespace std;
+
+struct BatchJob {
+    string domainFile;
+    string problemFile;
+    string observationFile;
+    int numObs = -1;
+    int kIterations = 5;
+    string name;
+};
+
+struct BatchOptions {
+    string resultsDir = "results";
+    int workers = 1;
+    ToolLimits limits;              // per job
+    string driver;                  // binary running a single job
+    vector<string> driverArgs;      // options passed on to every job
+    string cacheDir;                // model, baseline and grounding cache shared by the jobs, empty = one per job
+};
+
+// false if the manifest cannot be read or has a malformed line
+bool readManifest(const string& manifestFile, vector<BatchJob>& jobs);
+
+// shard in [0, numShards) of the job, by its problem file (as written in the manifest) and num_obs
+int shardOf(const BatchJob& job, int numShards);
+vector<BatchJob> shardJobs(const vector<BatchJob>& jobs, int shard, int numShards);
+
+// writes batch_checkpoint.txt, posteriors.txt and report.txt of the jobs of all shards to reportDir;
+// returns the number of jobs that did not finish or have no posteriors, -1 if nothing could be merged
+int mergeShards(const vector<string>& shardDirs, const string& reportDir);
+
+class BatchScheduler {
+public:
+    BatchScheduler(const vector<BatchJob>& jobs, const BatchOptions& options);
+
+    // returns the number of jobs that did not finish successfully
+    int run();
+
+private:
+    vector<BatchJob> jobs;
+    BatchOptions options;
+
+    vector<deque<int>> queues;      // job indices, one deque per worker
+    vector<mutex> queueLocks;
+
+    mutex checkpointLock;           // checkpoint file and console output
+    ofstream checkpoint;
+    int numFailed = 0;
+
+    string checkpointFile() const;
+    set<string> readCheckpoint() const;
+
+    bool nextJob(int worker, int& job);
+    void work(int worker);
+    void runJob(int worker, int job);
+};
+
+#endif /* BATCHSCHEDULER_H_ */
@@ -0,0 +1,92 @@
+/**
+ * Persistent cache of the grounded models, see GroundingCache.h
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <sys/stat.h>
+#include "GroundingCache.h"
+#include "Subprocess.h"
+#include "TextUtil.h"
+
+void GroundingCache::open(const string& dir, const string& toolDir) {
+    this->dir = dir;
+    toolStamp.clear();
+    {
+        lock_guard<mutex> lock(domainMutex);
+        domainHashes.clear();
+    }
+    if (this->dir.empty()) {
+        return;
+    }
+    if (this->dir.back() != '/') {
+        this->dir += "/";
+    }
+    if (!makeDirectories(this->dir)) {
+        cerr << "Warning: Cannot create grounding cache directory: " << this->dir << endl;
+        this->dir = "";
+        return;
+    }
+    // a rebuilt tool may ground differently
+    toolStamp = ::toolStamp(toolDir, {"pandaPIparser", "pandaPIgrounder"});
+}
+
+bool GroundingCache::enabled() const {
+    return !dir.empty();
+}
+
+// the hash is recomputed if the file changed since it was hashed
+bool GroundingCache::domainHash(const string& domainFile, uint64_t& hash) const {
+    struct stat st;
+    if (stat(domainFile.c_str(), &st) != 0) {
+        return false;
+    }
+    {
+        lock_guard<mutex> lock(domainMutex);
+        auto it = domainHashes.find(domainFile);
+        if (it != domainHashes.end() && it->second.size == st.st_size && it->second.modified == st.st_mtime) {
+            hash = it->second.hash;
+            return true;
+        }
+    }
+    string domain;
+    if (!readTextFile(domainFile, domain)) {
+        return false;
+    }
+    hash = hashText(to_string(domain.size()) + "\n" + domain);
+    lock_guard<mutex> lock(domainMutex);
+    domainHashes[domainFile] = {st.st_size, st.st_mtime, hash};
+    return true;
+}
+
+string GroundingCache::key(const string& domainFile, const string& problemFile) const {
+    uint64_t domain;
+    string problem;
+    if (!domainHash(domainFile, domain) || !readTextFile(problemFile, problem)) {
+        return "";
+    }
+    uint64_t hash = hashText(toolStamp);
+    hash = hashText(to_string(domain), hash);
+    hash = hashText(to_string(problem.size()) + "\n" + problem, hash);
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash);
+    return name;
+}
+
+bool GroundingCache::lookup(const string& key, const string& psas) const {
+    if (!enabled() || key.empty()) {
+        return false;
+    }
+    struct stat st;
+    if (stat((dir + key + ".psas").c_str(), &st) != 0 || st.st_size == 0) {
+        return false;
+    }
+    return publishFile(dir + key + ".psas", psas);
+}
+
+bool GroundingCache::store(const string& key, const string& psas) const {
+    if (!enabled() || key.empty()) {
+        return false;
+    }
+    return publishFile(psas, dir + key + ".psas");
+}
@@ -0,0 +1,62 @@
+/**
+ * Persistent cache of the grounded models
+ *
+ * The problems of a benchmark like kitchen-100 share one domain, and every
+ * job parses and grounds the same observation problem (and, with --reground,
+ * the same reduced domains) again. A grounded model is stored under a key
+ * computed from the content of the domain and the problem (and the identity
+ * of parser and grounder), so a later iteration, sweep or concurrent job
+ * sharing the directory skips both tools. The hypotheses removed so far are
+ * part of the key through the reduced domain; with groundOnce the original
+ * domain is grounded and the hypotheses are masked in memory, so every
+ * iteration may use the same entry.
+ *
+ * pandaPIparser reads domain and problem together, there is no lifted parse
+ * of the domain alone to share; the domain hash is computed once per file.
+ *
+ * Entries are hard links (see publishFile) published with a rename, readers
+ * of a path either see the complete old or the complete new model. Concurrent
+ * jobs grounding the same entry write the same content.
+ */
+
+#ifndef GROUNDINGCACHE_H_
+#define GROUNDINGCACHE_H_
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+class GroundingCache {
+public:
+    // the cache is disabled until it is opened with a directory
+    void open(const string& dir, const string& toolDir);
+
+    bool enabled() const;
+    // empty if one of the files cannot be read
+    string key(const string& domainFile, const string& problemFile) const;
+    // links the cached grounded model of key to psas
+    bool lookup(const string& key, const string& psas) const;
+    // links the grounded model into the cache
+    bool store(const string& key, const string& psas) const;
+
+private:
+    struct FileHash {
+        off_t size;
+        time_t modified;
+        uint64_t hash;
+    };
+
+    string dir;
+    string toolStamp;               // sizes and modification times of the tools
+    // content hashes of the domains by path, key() is called from the worker threads
+    mutable mutex domainMutex;
+    mutable unordered_map<string, FileHash> domainHashes;
+
+    bool domainHash(const string& domainFile, uint64_t& hash) const;
+};
+
+#endif /* GROUNDINGCACHE_H_ */
@@ -0,0 +1,295 @@
+/**
+ * HDDL domain or problem file parsed once into S-expressions, see HddlDocument.h
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include "HddlDocument.h"
+#include "TextUtil.h"
+
+static const vector<string> subtaskKeywords = {":subtasks", ":ordered-subtasks"};
+static const vector<string> goalKeywords = {":tasks", ":subtasks", ":ordered-tasks", ":ordered-subtasks"};
+static const string topLevelTaskComment = ";; (:htn :tasks (tlt))";
+
+// ============================================================================
+// PARSING
+// ============================================================================
+
+bool HddlDocument::read(const string& file) {
+    string content;
+    if (!readTextFile(file, content)) {
+        cerr << "Error: Cannot open HDDL file: " << file << endl;
+        return false;
+    }
+    return parse(content, file);
+}
+
+bool HddlDocument::parse(const string& content, const string& name) {
+    fileName = name;
+    text = content;
+    lineStarts.clear();
+    nodes.clear();
+    roots.clear();
+    comments.clear();
+    methods.clear();
+    htnBlocks.clear();
+    goalBlock = goalKeyword = goalValue = -1;
+
+    if (!text.empty()) {
+        lineStarts.push_back(0);
+    }
+    vector<int> open;
+    int line = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '\n') {
+            line++;
+            if (++i < text.size()) lineStarts.push_back(i);
+            continue;
+        }
+        if (isspace((unsigned char) c)) {
+            i++;
+            continue;
+        }
+        if (c == ';') {
+            comments.push_back(i);
+            while (i < text.size() && text[i] != '\n') i++;
+            continue;
+        }
+        if (c == ')') {
+            if (open.empty()) {
+                cerr << "Error: Unbalanced ')' in " << fileName << " at line " << line + 1 << endl;
+                return false;
+            }
+            nodes[open.back()].end = i + 1;
+            nodes[open.back()].lastLine = line;
+            open.pop_back();
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        if (c == '(') {
+            i++;
+        } else {
+            while (i < text.size() && !isspace((unsigned char) text[i]) && text[i] != '(' && text[i] != ')' && text[i] != ';') i++;
+        }
+        int node = nodes.size();
+        nodes.push_back({start, i, line, line, {}});
+        if (open.empty()) {
+            roots.push_back(node);
+        } else {
+            nodes[open.back()].children.push_back(node);
+        }
+        if (c == '(') {
+            open.push_back(node);
+        }
+    }
+    if (!open.empty()) {
+        cerr << "Error: Unclosed '(' in " << fileName << " at line " << nodes[open.back()].firstLine + 1 << endl;
+        return false;
+    }
+    buildIndex();
+    return true;
+}
+
+bool HddlDocument::isAtom(int node, const char* atom) const {
+    const Node& n = nodes[node];
+    return !isList(node) && text.compare(n.begin, n.end - n.begin, atom) == 0;
+}
+
+string HddlDocument::atomText(int node) const {
+    return text.substr(nodes[node].begin, nodes[node].end - nodes[node].begin);
+}
+
+// index of the first child of list that is one of the keywords, -1 if there is none
+int HddlDocument::keywordChild(int list, const vector<string>& keywords) const {
+    const vector<int>& children = nodes[list].children;
+    for (size_t i = 0; i < children.size(); i++) {
+        for (const string& keyword : keywords) {
+            if (isAtom(children[i], keyword.c_str())) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+// the methods and :htn blocks are the lists directly inside "(define ...)"
+void HddlDocument::buildIndex() {
+    for (int root : roots) {
+        if (!isList(root)) continue;
+        for (int child : nodes[root].children) {
+            const vector<int>& parts = nodes[child].children;
+            if (!isList(child) || parts.empty()) continue;
+            if (isAtom(parts[0], ":method") && parts.size() > 1 && !isList(parts[1])) {
+                methods[atomText(parts[1])].push_back(child);
+            } else if (isAtom(parts[0], ":htn")) {
+                htnBlocks.push_back(child);
+                int k = keywordChild(child, goalKeywords);
+                if (goalBlock < 0 && k >= 0 && k + 1 < (int) parts.size()) {
+                    goalBlock = child;
+                    goalKeyword = parts[k];
+                    goalValue = parts[k + 1];
+                }
+            }
+        }
+    }
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+
+bool HddlDocument::hasMethod(const string& name) const {
+    return methods.count(name) > 0;
+}
+
+string HddlDocument::methodSubtasks(const string& name) const {
+    auto it = methods.find(name);
+    if (it == methods.end()) {
+        return "";
+    }
+    int method = it->second.front();
+    int k = keywordChild(method, subtaskKeywords);
+    if (k < 0 || k + 1 >= (int) nodes[method].children.size()) {
+        return "";
+    }
+    const Node& value = nodes[nodes[method].children[k + 1]];
+    string subtasks = text.substr(value.begin, value.end - value.begin);
+    replace(subtasks.begin(), subtasks.end(), '\n', ' ');
+    return subtasks;
+}
+
+int HddlDocument::numGoalTasks() const {
+    if (goalValue < 0) {
+        return -1;
+    }
+    const vector<int>& parts = nodes[goalValue].children;
+    if (isList(goalValue) && !parts.empty() && isAtom(parts[0], "and")) {
+        return parts.size() - 1;
+    }
+    return 1;
+}
+
+// ============================================================================
+// VARIANTS
+// ============================================================================
+
+size_t HddlDocument::lineEnd(int line) const {
+    size_t end = text.find('\n', lineStarts[line]);
+    return (end == string::npos) ? text.size() : end;
+}
+
+// the edits are applied in the order of their first line, an edit overlapping an earlier one is skipped
+string HddlDocument::emit(vector<LineEdit> edits) const {
+    sort(edits.begin(), edits.end(), [](const LineEdit& a, const LineEdit& b) { return a.first < b.first; });
+    string out;
+    out.reserve(text.size() + 64 * edits.size());
+    int line = 0;
+    auto copyLine = [&](int l, const string& prefix, size_t skip) {
+        size_t begin = lineStarts[l];
+        size_t end = lineEnd(l);
+        out += prefix;
+        begin = min(begin + skip, end);
+        out.append(text, begin, end - begin);
+        out += '\n';
+    };
+    for (const LineEdit& edit : edits) {
+        if (edit.first < line) continue;
+        for (; line < edit.first; line++) {
+            copyLine(line, "", 0);
+        }
+        for (const string& inserted : edit.before) {
+            out += inserted;
+            out += '\n';
+        }
+        for (; line <= edit.last; line++) {
+            if (!edit.drop) copyLine(line, edit.prefix, edit.skip);
+        }
+    }
+    for (; line < numLines(); line++) {
+        copyLine(line, "", 0);
+    }
+    return out;
+}
+
+string HddlDocument::withMethodsCommented(const vector<string>& names, const string& prefix) const {
+    vector<LineEdit> edits;
+    for (const string& name : names) {
+        auto it = methods.find(name);
+        if (it == methods.end()) continue;
+        for (int method : it->second) {
+            LineEdit edit;
+            edit.first = nodes[method].firstLine;
+            edit.last = nodes[method].lastLine;
+            edit.prefix = prefix;
+            edits.push_back(edit);
+        }
+    }
+    return emit(edits);
+}
+
+string HddlDocument::withMethodsRemoved(const vector<string>& names) const {
+    vector<LineEdit> edits;
+    for (const string& name : names) {
+        auto it = methods.find(name);
+        if (it == methods.end()) continue;
+        for (int method : it->second) {
+            LineEdit edit;
+            edit.first = nodes[method].firstLine;
+            edit.last = nodes[method].lastLine;
+            edit.drop = true;
+            edits.push_back(edit);
+        }
+    }
+    return emit(edits);
+}
+
+// the new line keeps what stands before the keyword and after the value (without a trailing comment),
+// e.g. "(:htn :tasks (x)) ;; org." becomes "(:htn :tasks <tasks>)"
+bool HddlDocument::withGoalTasks(const string& tasks, string& output) const {
+    if (goalValue < 0) {
+        return false;
+    }
+    const Node& keyword = nodes[goalKeyword];
+    const Node& value = nodes[goalValue];
+    string before = text.substr(lineStarts[keyword.firstLine], keyword.begin - lineStarts[keyword.firstLine]);
+    string after = text.substr(value.end, lineEnd(value.lastLine) - value.end);
+    after = after.substr(0, after.find(';'));
+    after.erase(find_if(after.rbegin(), after.rend(), [](char c) { return !isspace((unsigned char) c); }).base(), after.end());
+
+    LineEdit edit;
+    edit.first = keyword.firstLine;
+    edit.last = value.lastLine;
+    edit.prefix = ";";
+    edit.before.push_back(before + atomText(goalKeyword) + " " + tasks + after);
+    output = emit({edit});
+    return true;
+}
+
+string HddlDocument::withTopLevelTaskActivated() const {
+    vector<LineEdit> edits;
+    for (size_t comment : comments) {
+        int line = upper_bound(lineStarts.begin(), lineStarts.end(), comment) - lineStarts.begin() - 1;
+        if (lineStarts[line] == comment && text.compare(comment, topLevelTaskComment.size(), topLevelTaskComment) == 0) {
+            LineEdit edit;
+            edit.first = edit.last = line;
+            edit.skip = 3;
+            edits.push_back(edit);
+        }
+    }
+    for (int block : htnBlocks) {
+        const vector<int>& parts = nodes[block].children;
+        if (parts.size() > 1 && isAtom(parts[1], ":tasks")) {
+            LineEdit edit;
+            edit.first = nodes[block].firstLine;
+            edit.last = nodes[block].lastLine;
+            edit.prefix = ";;";
+            edits.push_back(edit);
+        }
+    }
+    return emit(edits);
+}
@@ -0,0 +1,93 @@
+/**
+ * HDDL domain or problem file parsed once into S-expressions
+ *
+ * The reader keeps the text and records every list and atom with its byte
+ * range and lines; comments (";" to the end of the line) are skipped but
+ * remembered. The methods are indexed by name and the :htn block of a
+ * problem is located once, so that the rewritten variants of HddlRewrite.h
+ * (hypothesis removed, baseline goal, mtlt/tlt placeholder) are emitted by
+ * splicing lines of the original text in time linear in the output, without
+ * scanning the file again.
+ *
+ * All variants are line-based like the files the planner toolchain reads:
+ * the lines of a removed method are commented out or dropped as a whole, and
+ * every output line ends with '\n'. The document is not changed by emitting,
+ * const members may be called from several threads.
+ */
+
+#ifndef HDDLDOCUMENT_H_
+#define HDDLDOCUMENT_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+class HddlDocument {
+public:
+    // false (with an error message) if the file cannot be read or its parentheses are unbalanced
+    bool read(const string& file);
+    bool parse(const string& text, const string& name = "");
+
+    const string& file() const { return fileName; }
+    bool hasMethod(const string& name) const;
+
+    // text of the :subtasks (or :ordered-subtasks) of the method, line breaks as spaces, empty if not found
+    string methodSubtasks(const string& name) const;
+
+    // the lines of all methods with one of the names, commented out with prefix or dropped
+    string withMethodsCommented(const vector<string>& names, const string& prefix) const;
+    string withMethodsRemoved(const vector<string>& names) const;
+
+    // number of tasks in the :tasks of the :htn block (the elements of an "(and ...)"), -1 if there is none
+    int numGoalTasks() const;
+    // the :tasks of the :htn block replaced by tasks, the old lines are kept commented out with ";";
+    // false if the problem has no :tasks
+    bool withGoalTasks(const string& tasks, string& output) const;
+
+    // the commented ";; (:htn :tasks (tlt))" line activated and the other :htn blocks commented out with ";;"
+    string withTopLevelTaskActivated() const;
+
+private:
+    struct Node {
+        size_t begin;          // '(' of a list or the first character of an atom
+        size_t end;            // one past the ')' or the atom
+        int firstLine;
+        int lastLine;
+        vector<int> children;  // lists only
+    };
+
+    // lines first..last are dropped or written as prefix + line.substr(skip), before goes in front of them
+    struct LineEdit {
+        int first;
+        int last;
+        string prefix;
+        size_t skip = 0;
+        bool drop = false;
+        vector<string> before;
+    };
+
+    string fileName;
+    string text;
+    vector<size_t> lineStarts;
+    vector<Node> nodes;
+    vector<int> roots;                // top-level nodes, normally the single "(define ...)"
+    vector<size_t> comments;          // offset of every ';' that starts a comment
+    unordered_map<string, vector<int>> methods;
+    vector<int> htnBlocks;            // "(:htn ...)" lists
+    int goalBlock = -1;               // the first :htn block with :tasks
+    int goalKeyword = -1;             // its :tasks atom and value
+    int goalValue = -1;
+
+    bool isList(int node) const { return text[nodes[node].begin] == '('; }
+    bool isAtom(int node, const char* atom) const;
+    string atomText(int node) const;
+    size_t lineEnd(int line) const;   // offset of the '\n' of line (or end of text)
+    int numLines() const { return lineStarts.size(); }
+    int keywordChild(int list, const vector<string>& keywords) const;
+    void buildIndex();
+    string emit(vector<LineEdit> edits) const;
+};
+
+#endif /* HDDLDOCUMENT_H_ */
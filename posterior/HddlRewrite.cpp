@@ -0,0 +1,173 @@
+/**
+ * Text-level rewriting of HDDL domain and problem files, see HddlRewrite.h
+ */
+
+#include <cctype>
+#include "HddlRewrite.h"
+#include "TextUtil.h"
+
+const string removedMethodPrefix = ";; REMOVED: ";
+
+static bool writeOutput(const string& outputFile, const string& content) {
+    if (!writeTextFile(outputFile, content)) {
+        cerr << "Error: Cannot write to output file: " << outputFile << endl;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// DOMAIN MANIPULATION
+// ============================================================================
+
+bool removeHypothesisFromDomain(const string& domainFile,
+                                const string& hypothesis,
+                                const string& outputFile) {
+    HddlDocument domain;
+    if (!domain.read(domainFile)) {
+        return false;
+    }
+    return writeOutput(outputFile, domain.withMethodsCommented({hypothesis}, removedMethodPrefix));
+}
+
+// ============================================================================
+// PROBLEM FILE CREATION
+// ============================================================================
+
+string extractSubtasksFromMethod(const string& domainFile, const string& methodName) {
+    HddlDocument domain;
+    if (!domain.read(domainFile)) {
+        return "";
+    }
+    return domain.methodSubtasks(methodName);
+}
+
+bool createProblemWithGoal(const string& templateFile,
+                          const string& goalTask,
+                          const string& outputFile) {
+    HddlDocument problem;
+    if (!problem.read(templateFile)) {
+        return false;
+    }
+    string content;
+    if (!problem.withGoalTasks(goalTask, content)) {
+        cerr << "Error: No :htn :tasks in problem file: " << templateFile << endl;
+        return false;
+    }
+    return writeOutput(outputFile, content);
+}
+
+// ============================================================================
+// GENERATE MTLT VERSION
+// ============================================================================
+
+string goalPlaceholder(const HddlDocument& problem) {
+    return (problem.numGoalTasks() > 1) ? "mtlt" : "tlt";
+}
+
+/**
+ * Generate HDDL problem file with tasks commented out and replaced with mtlt/tlt.
+ * This creates a version suitable for goal recognition where the specific tasks
+ * are hidden and replaced with a generic top-level task placeholder.
+ * 
+ * The placeholder is mtlt if the :tasks of the problem are an (and ...) of
+ * several tasks and tlt otherwise.
+ * 
+ * @param hddlFile Input HDDL problem file
+ * @param outputFile Output HDDL problem file
+ * @return Task placeholder used ("mtlt" for multiple tasks, "tlt" for single task)
+ */
+string generateMtltVersion(const string& hddlFile, 
+                          const string& outputFile) {
+    HddlDocument problem;
+    if (!problem.read(hddlFile)) {
+        return "";
+    }
+    string taskPlaceholder = goalPlaceholder(problem);
+    string content;
+    if (!problem.withGoalTasks("(" + taskPlaceholder + ")", content)) {
+        cerr << "Error: No :htn :tasks in problem file: " << hddlFile << endl;
+        return "";
+    }
+    if (!writeOutput(outputFile, content)) {
+        return "";
+    }
+    return taskPlaceholder;
+}
+
+// ============================================================================
+// TOP-LEVEL TASK WRAPPER DOMAINS
+// ============================================================================
+
+static inline bool isNameChar(char c) {
+    return isalnum((unsigned char) c) || c == '_' || c == '-';
+}
+
+// first grounded task "name[args]" in text, the args must not be empty
+static bool findGroundedTask(const string& text, string& name, string& args) {
+    size_t p = 0;
+    while (p < text.size()) {
+        if (!isNameChar(text[p])) {
+            p++;
+            continue;
+        }
+        size_t end = p;
+        while (end < text.size() && isNameChar(text[end])) end++;
+        if (end < text.size() && text[end] == '[') {
+            size_t close = text.find(']', end + 1);
+            if (close == string::npos) return false;
+            if (close > end + 1) {
+                name = text.substr(p, end - p);
+                args = text.substr(end + 1, close - end - 1);
+                return true;
+            }
+        }
+        p = end;
+    }
+    return false;
+}
+
+bool wrapTopLevelTask(const string& problemFile, const string& outputFile) {
+    HddlDocument problem;
+    if (!problem.read(problemFile)) {
+        return false;
+    }
+    return writeOutput(outputFile, problem.withTopLevelTaskActivated());
+}
+
+string topLevelMethodName(const string& hypothesis) {
+    string name, args;
+    if (findGroundedTask(hypothesis, name, args)) {
+        return "m-tlt-" + name;
+    }
+    return "";
+}
+
+bool removeTopLevelTaskMethod(const string& domainFile,
+                              const string& hypothesis,
+                              const string& outputFile) {
+    string method = topLevelMethodName(hypothesis);
+    if (method.empty()) {
+        cerr << "Error: No grounded top-level task in hypothesis: " << hypothesis << endl;
+        return false;
+    }
+    HddlDocument domain;
+    if (!domain.read(domainFile)) {
+        return false;
+    }
+    return writeOutput(outputFile, domain.withMethodsRemoved({method}));
+}
+
+string hypothesisToPredicate(const string& hypothesis) {
+    string name, args;
+    if (!findGroundedTask(hypothesis, name, args)) {
+        return "";
+    }
+
+    string predicate_str = "(" + name;
+    for (const string& arg : split(args, ',')) {
+        predicate_str += " " + arg;
+    }
+    predicate_str += ")";
+    return predicate_str;
+}
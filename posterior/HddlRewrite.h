@@ -0,0 +1,61 @@
+/**
+ * Text-level rewriting of HDDL domain and problem files
+ *
+ * The file-based functions parse their input with HddlDocument and write one
+ * variant; the driver keeps the documents of a run and emits the variants of
+ * every iteration from them (HddlDocument.h).
+ *
+ * Two domain styles are supported:
+ *   - explicit hypotheses (kitchen): the problem is rewritten to an mtlt/tlt
+ *     placeholder and each hypothesis is a "(:method hypothesis-N" of it
+ *   - top-level task wrapper (Monroe): the problem contains a commented
+ *     "(:htn :tasks (tlt))" line and each goal is reachable via "m-tlt-<task>"
+ */
+
+#ifndef HDDLREWRITE_H_
+#define HDDLREWRITE_H_
+
+#include <iostream>
+#include <string>
+#include "HddlDocument.h"
+
+using namespace std;
+
+// prefix of the lines of a removed hypothesis method
+extern const string removedMethodPrefix;
+
+// comment out the method block of the given hypothesis with ";; REMOVED: "
+bool removeHypothesisFromDomain(const string& domainFile,
+                                const string& hypothesis,
+                                const string& outputFile);
+
+// :subtasks text of the given method, empty if not found
+string extractSubtasksFromMethod(const string& domainFile, const string& methodName);
+
+// replace the active :tasks of the problem by goalTask, the old tasks are kept as comment
+bool createProblemWithGoal(const string& templateFile,
+                           const string& goalTask,
+                           const string& outputFile);
+
+// "mtlt" if the :tasks of the problem are several tasks, "tlt" otherwise
+string goalPlaceholder(const HddlDocument& problem);
+
+// returns the placeholder that was used ("mtlt" or "tlt"), empty on error
+string generateMtltVersion(const string& hddlFile,
+                           const string& outputFile);
+
+// activate the commented "(:htn :tasks (tlt))" line and comment out the original tasks
+bool wrapTopLevelTask(const string& problemFile, const string& outputFile);
+
+// "m-tlt-<task>" for a grounded hypothesis "<task>[args]", empty if there is none
+string topLevelMethodName(const string& hypothesis);
+
+// drop the m-tlt method of the hypothesis from the domain
+bool removeTopLevelTaskMethod(const string& domainFile,
+                              const string& hypothesis,
+                              const string& outputFile);
+
+// "set-up-shelter[mendon-pond]" -> "(set-up-shelter mendon-pond)", empty if not grounded
+string hypothesisToPredicate(const string& hypothesis);
+
+#endif /* HDDLREWRITE_H_ */
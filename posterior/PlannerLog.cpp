@@ -0,0 +1,146 @@
+/**
+ * Hypothesis extraction from pplanner logs, see PlannerLog.h
+ */
+
+#include <fstream>
+#include "PlannerLog.h"
+#include "TextUtil.h"
+
+// ============================================================================
+// EXPLICIT HYPOTHESIS DOMAINS
+// ============================================================================
+
+string extractInstantiatedSubtasks(const ParsedLog& log) {
+    // the hypothesis name and the splitted lines are collected by the parser
+    const string& hypothesisName = log.splittedHypothesis;
+    if (hypothesisName.empty()) {
+        return "";
+    }
+    
+    // Find splitted lines with actual subtasks
+    vector<string> tasks;
+    for (const string& l : log.splittedLines) {
+        // Look for hypothesis_splitted lines
+        // Pattern: "1089 hypothesis-1_splitted_1088[] -> <...;makeBolognese[pan1];...>"
+        if (contains(l, hypothesisName) && contains(l, "_splitted")) {
+            size_t arrowPos = l.find("->");
+            if (arrowPos == string::npos) continue;
+            
+            string afterArrow = l.substr(arrowPos + 2);
+            afterArrow = trim(afterArrow);
+            
+            // Look for method encoding with subtasks
+            // Pattern: "<...; subtask[params];...>"
+            if (startsWith(afterArrow, "<")) {
+                size_t start = 1;  // Skip <
+                size_t end = afterArrow.find('>');
+                if (end == string::npos) continue;
+                
+                string methodEncoding = afterArrow.substr(start, end - start);
+                vector<string> parts = split(methodEncoding, ';');
+                
+                // Look for task[params] patterns (skip method names starting with m-, numbers, etc.)
+                for (const string& part : parts) {
+                    string task = trim(part);
+                    if (task.empty() || startsWith(task, "m-") || startsWith(task, "0") || 
+                        startsWith(task, "-") || task.find_first_not_of("0123456789,-") == string::npos ||
+                        startsWith(task, "_")) {
+                        continue;  // Skip method names and numeric encodings
+                    }
+                    
+                    // Convert task[param1,param2] to (task param1 param2)
+                    size_t bracketPos = task.find('[');
+                    if (bracketPos != string::npos) {
+                        string taskName = task.substr(0, bracketPos);
+                        size_t closeBracket = task.find(']');
+                        if (closeBracket != string::npos) {
+                            string params = task.substr(bracketPos + 1, closeBracket - bracketPos - 1);
+                            // Replace commas with spaces
+                            for (char& c : params) {
+                                if (c == ',') c = ' ';
+                            }
+                            tasks.push_back("(" + taskName + " " + params + ")");
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    // Build result
+    if (tasks.size() == 0) {
+        return "";
+    } else if (tasks.size() == 1) {
+        return tasks[0];
+    } else {
+        string result = "(and";
+        for (const string& t : tasks) {
+            result += " " + t;
+        }
+        result += ")";
+        return result;
+    }
+}
+
+string extractHypothesisFromLog(const ParsedLog& log) {
+    // Strategy 1: mtlt/tlt decomposition in the decomposition tree,
+    //   "37 mtlt[] -> hypothesis-1 ..." or "436 mtlt[] -> <<hypothesis-29;..."
+    // Strategy 2: abstract task decomposition in the plan,
+    //   "0 <abs> hypothesis_name -> method_name"
+    // The first line matching either one is taken, see parsePlannerLog()
+    return log.hypothesis;
+}
+
+string extractHypothesisFromLog(istream& file) {
+    return extractHypothesisFromLog(parsePlannerLog(file));
+}
+
+string extractInstantiatedSubtasks(istream& file) {
+    return extractInstantiatedSubtasks(parsePlannerLog(file));
+}
+
+string extractHypothesisFromLog(const string& logFile) {
+    ifstream file(logFile);
+    if (!file.is_open()) {
+        cerr << "Error: Cannot open log file: " << logFile << endl;
+        return "";
+    }
+    return extractHypothesisFromLog(file);
+}
+
+string extractInstantiatedSubtasks(const string& logFile) {
+    ifstream file(logFile);
+    if (!file.is_open()) {
+        cerr << "Error: Cannot open log file: " << logFile << endl;
+        return "";
+    }
+    return extractInstantiatedSubtasks(file);
+}
+
+// ============================================================================
+// TOP-LEVEL TASK WRAPPER DOMAINS
+// ============================================================================
+
+bool extractTopLevelHypothesis(const ParsedLog& log, string& hypothesis) {
+    // The line "0 __top[] -> __top_method {num}" ends with the id of the
+    // method encoding of the hypothesis, the parser looks up that line and
+    // the first grounded task "name[args]" in it (or the line of its child,
+    // if the task is given as e.g. "13 tlt[] -> m-tlt-plow-road 2329")
+    if (!log.hasTopLine) {
+        return false;
+    }
+    hypothesis = log.topHypothesis;
+    return true;
+}
+
+bool extractTopLevelHypothesis(istream& file, string& hypothesis) {
+    return extractTopLevelHypothesis(parsePlannerLog(file), hypothesis);
+}
+
+bool isProvenUnsolvable(const ParsedLog& log) {
+    return log.provenUnsolvable;
+}
+
+bool isProvenUnsolvable(istream& file) {
+    return isProvenUnsolvable(parsePlannerLog(file));
+}
@@ -0,0 +1,41 @@
+/**
+ * Hypothesis extraction from pplanner logs
+ *
+ * All functions work on a log read by parsePlannerLog(), so a log that is
+ * used for several of them is only read once. The stream and file name
+ * variants read the log themselves and are kept for the CLI tools.
+ */
+
+#ifndef PLANNERLOG_H_
+#define PLANNERLOG_H_
+
+#include <iostream>
+#include <string>
+#include "../likelihood/PlannerLogParser.h"
+
+using namespace std;
+
+// Explicit hypothesis domains (kitchen): name of the hypothesis method chosen
+// for mtlt[]/tlt[], e.g. "hypothesis-3"
+string extractHypothesisFromLog(const ParsedLog& log);
+string extractHypothesisFromLog(istream& log);
+string extractHypothesisFromLog(const string& logFile);
+
+// Explicit hypothesis domains (kitchen): instantiated subtasks of the chosen
+// hypothesis, e.g. "(and (makeNoodles spaghetti pot1) (makeBolognese pan1))"
+string extractInstantiatedSubtasks(const ParsedLog& log);
+string extractInstantiatedSubtasks(istream& log);
+string extractInstantiatedSubtasks(const string& logFile);
+
+// Top-level task wrapper domains (Monroe): the grounded task below __top[],
+// e.g. "set-up-shelter[mendon-pond]". If the decomposition line of the child
+// does not carry the instance, the child line itself is returned.
+// Returns false if the log contains no "__top[] ->" line.
+bool extractTopLevelHypothesis(const ParsedLog& log, string& hypothesis);
+bool extractTopLevelHypothesis(istream& log, string& hypothesis);
+
+// true if the last line of the log reports "Status: Proven unsolvable"
+bool isProvenUnsolvable(const ParsedLog& log);
+bool isProvenUnsolvable(istream& log);
+
+#endif /* PLANNERLOG_H_ */
@@ -0,0 +1,979 @@
+/**
+ * In-process posterior estimation via iterative hypothesis selection, see PosteriorDriver.h
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <cstdio>
+#include <dirent.h>
+#include "PosteriorDriver.h"
+#include "../htnModel/Trace.h"
+#include "HddlRewrite.h"
+#include "PlannerLog.h"
+#include "Subprocess.h"
+#include "TextUtil.h"
+#include "WorkerPool.h"
+
+domainStyle detectDomainStyle(const string& domainFile) {
+    ifstream file(domainFile);
+    string line;
+    while (getline(file, line)) {
+        if (contains(line, "(:method hypothesis-")) {
+            return ExplicitHypotheses;
+        }
+    }
+    return TltWrapper;
+}
+
+PosteriorDriver::PosteriorDriver(const DriverConfig& config) : config(config) {
+    if (this->config.workDir.empty()) {
+        this->config.workDir = ".";
+    }
+    if (this->config.workDir.back() != '/') {
+        this->config.workDir += "/";
+    }
+    if (this->config.toolDir.empty()) {
+        this->config.toolDir = ".";
+    }
+    if (this->config.toolDir.back() != '/') {
+        this->config.toolDir += "/";
+    }
+    if (((this->config.stopEpsilon > 0.0) || this->config.stopOnTop) && !std::isfinite(this->config.stopLogBound)) {
+        // the likelihoods found so far do not bound the later ones, each is normalized by its own baseline
+        cerr << "Warning: Early stopping needs a likelihood bound (stopLogBound, --stop-bound), it is disabled" << endl;
+        this->config.stopEpsilon = 0.0;
+        this->config.stopOnTop = false;
+    }
+}
+
+PosteriorDriver::~PosteriorDriver() {
+    delete observationModel;
+}
+
+const vector<HypothesisRecord>& PosteriorDriver::getResults() const {
+    return results;
+}
+
+const vector<SweepPoint>& PosteriorDriver::getSweepResults() const {
+    return sweepResults;
+}
+
+int PosteriorDriver::getIterationsSaved() const {
+    return iterationsSaved;
+}
+
+string PosteriorDriver::iterationFile(const string& suffix) const {
+    return iterationFile(iteration, suffix);
+}
+
+string PosteriorDriver::iterationFile(int iter, const string& suffix) const {
+    return runDir + to_string(iter) + suffix;
+}
+
+string PosteriorDriver::tool(const string& name) const {
+    return config.toolDir + name;
+}
+
+void PosteriorDriver::loadModel(Model* htn, const string& psas) const {
+    TRACE_SCOPE("model_load");
+    if (config.modelCacheDir.empty()) {
+        htn->read(psas);
+    } else {
+        htn->readCached(psas, config.modelCacheDir);
+    }
+    TRACE_ARG("actions", htn->numActions);
+    TRACE_ARG("methods", htn->numMethods);
+}
+
+// ============================================================================
+// SETUP
+// ============================================================================
+
+int PosteriorDriver::prepare() {
+    TRACE_SCOPE("prepare");
+    if (!makeDirectories(config.workDir)) {
+        cerr << "Error: Cannot create work directory: " << config.workDir << endl;
+        return 1;
+    }
+    if (!config.modelCacheDir.empty() && !makeDirectories(config.modelCacheDir)) {
+        cerr << "Warning: Cannot create model cache directory: " << config.modelCacheDir << endl;
+        config.modelCacheDir = "";
+    }
+
+    // the variants of every iteration are emitted from these (a sweep parses them once)
+    if (problemDocument.file() != config.problemFile && !problemDocument.read(config.problemFile)) {
+        return 1;
+    }
+    if (!config.groundOnce && domainDocument.file() != config.domainFile && !domainDocument.read(config.domainFile)) {
+        return 1;
+    }
+    string content;
+    if (config.style == TltWrapper) {
+        observationProblem = config.workDir + "problem_tlt.hddl";
+        content = problemDocument.withTopLevelTaskActivated();
+    } else {
+        observationProblem = config.workDir + "problem_mtlt.hddl";
+        if (!problemDocument.withGoalTasks("(" + goalPlaceholder(problemDocument) + ")", content)) {
+            cerr << "Error: No :htn :tasks in problem file: " << config.problemFile << endl;
+            return 1;
+        }
+    }
+    if (!writeTextFile(observationProblem, content)) {
+        cerr << "Error: Cannot write observation problem: " << observationProblem << endl;
+        return 1;
+    }
+
+    // the observations are the same for all iterations and prefix lengths, read them once
+    observations.clear();
+    encoder.readSolution(config.observationFile, observations, -1);
+    numObsUsed = config.numObs;
+    runDir = config.workDir;
+    currentDomain = config.domainFile;
+    removedMethods.clear();
+    encoder.clearCache();
+    delete observationModel;
+    observationModel = nullptr;
+    baselineCache.open(config.baselineCacheDir, config.toolDir);
+    groundingCache.open(config.groundingCacheDir, config.toolDir);
+
+#ifdef DEBUG
+    cout << "Domain style: " << (config.style == TltWrapper ? "top-level task wrapper" : "explicit hypotheses") << endl;
+    cout << "Observation problem: " << observationProblem << endl;
+    cout << "Observations used for encoding: " << ((numObsUsed < 0) ? observations.size() : min(observations.size(), (size_t) numObsUsed)) << endl;
+    cout << "Hypothesis removal: " << (config.groundOnce ? "masking grounded methods" : "reduced domain") << endl;
+    cout << endl;
+#endif
+    return 0;
+}
+
+// ============================================================================
+// ITERATION STEPS
+// ============================================================================
+
+int PosteriorDriver::ground(int iter, const string& domain, const string& problem, const string& prefix, string& psas) const {
+    TRACE_SCOPE("ground");
+    string parsed = iterationFile(iter, prefix + "_parsed.htn");
+    psas = iterationFile(iter, prefix + "_grounded.psas");
+
+    string key = groundingCache.enabled() ? groundingCache.key(domain, problem) : "";
+    if (!key.empty() && groundingCache.lookup(key, psas)) {
+        TRACE_ARG("cache_hit", 1);
+#ifdef DEBUG
+        cout << "Iteration " << iter << " - Grounded model found in the cache (" << key << ")" << endl;
+#endif
+        return 0;
+    }
+    // the tools write new files, a cached model linked to the old ones stays as it is
+    remove(parsed.c_str());
+    remove(psas.c_str());
+    int ret = runTool({tool("pandaPIparser"), domain, problem, parsed}, iterationFile(iter, prefix + "_parser.log"));
+    if (ret != 0) {
+        cerr << "Iteration " << iter << " - Error: Parsing failed (" << ret << "), see " << iterationFile(iter, prefix + "_parser.log") << endl;
+        return 1;
+    }
+    ret = runTool({tool("pandaPIgrounder"), "-q", parsed, psas}, iterationFile(iter, prefix + "_ground.log"));
+    if (ret != 0) {
+        cerr << "Iteration " << iter << " - Error: Grounding failed (" << ret << "), see " << iterationFile(iter, prefix + "_ground.log") << endl;
+        return 1;
+    }
+    if (!key.empty() && !groundingCache.store(key, psas)) {
+        cerr << "Iteration " << iter << " - Warning: Cannot store the grounded model in the cache" << endl;
+    }
+    return 0;
+}
+
+// the log is parsed while the planner writes it and only kept in logFile with config.plannerLogs (or keepLog)
+int PosteriorDriver::solve(const string& input, const string& logFile, ParsedLog& log, bool keepLog) const {
+    TRACE_SCOPE("solve");
+    PlannerLogReader reader;
+    int ret = runToolPiped({tool("pplanner"), input}, (config.plannerLogs || keepLog) ? logFile : "",
+                           [&reader](const char* data, size_t size) { reader.feed(data, size); });
+    log = reader.finish();
+    TRACE_ARG("generated_nodes", log.generatedNodes);
+    TRACE_ARG("plan_length", log.plan.size());
+    return ret == 0 ? 0 : 1;
+}
+
+// all solutions of the observation search, at most config.solutionsPerSearch
+int PosteriorDriver::solveObservations(const string& pgr, vector<ParsedLog>& logs) const {
+    TRACE_SCOPE("solve_observations");
+    vector<string> args = {tool("pplanner")};
+    args.insert(args.end(), config.plannerOptions.begin(), config.plannerOptions.end());
+    args.push_back(pgr);
+
+    PlannerLogReader reader(config.solutionsPerSearch > 1);
+    int ret = runToolPiped(args, config.plannerLogs ? iterationFile("_obs_pgr.log") : "",
+                           [&reader](const char* data, size_t size) { reader.feed(data, size); });
+    logs = reader.finishAll();
+    if (logs.size() > (size_t) max(config.solutionsPerSearch, 1)) {
+        logs.resize(max(config.solutionsPerSearch, 1));
+    }
+    TRACE_ARG("solutions", logs.size());
+    TRACE_ARG("generated_nodes", logs.back().generatedNodes);
+    return ret == 0 ? 0 : 1;
+}
+
+int PosteriorDriver::loadObservationModel() {
+    TRACE_SCOPE("load_observation_model");
+    string psas;
+    if (ground(iteration, currentDomain, observationProblem, "", psas) != 0) {
+        return 1;
+    }
+    encoder.clearCache();
+    delete observationModel;
+    observationModel = new Model();
+    loadModel(observationModel, psas);
+
+    // prefixes of the observations are encoded from this mapping
+    if (!encoder.mapPlan(observationModel, observations, observationIds)) {
+        cerr << "Iteration " << iteration << " - Error: The observations contain an unknown action" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// undoes the hypothesis removal of a previous selection
+void PosteriorDriver::restoreHypotheses() {
+    currentDomain = config.domainFile;
+    removedMethods.clear();
+    if (observationModel != nullptr) {
+        if (config.groundOnce) {
+            observationModel->enableAllMethods();
+        } else {
+            encoder.clearCache();
+            delete observationModel;
+            observationModel = nullptr;
+        }
+    }
+}
+
+// returns 2 if the observations cannot be explained by any remaining hypothesis
+int PosteriorDriver::encodeObservations(const string& pgr) {
+    TRACE_SCOPE("encode_observations");
+    ofstream out(pgr);
+    if (!out.is_open()) {
+        cerr << "Iteration " << iteration << " - Error: Cannot write PGR file: " << pgr << endl;
+        return 1;
+    }
+    size_t numObs = (numObsUsed < 0) ? observationIds.size() : min(observationIds.size(), (size_t) numObsUsed);
+    vector<int> prefix(observationIds.begin(), observationIds.begin() + numObs);
+    encodingResult res = encoder.encodePrefix(observationModel, prefix, config.encoding, false, out);
+    TRACE_ARG("observations", numObs);
+    TRACE_ARG("pgr_bytes", out.tellp());
+    out.close();
+
+    if (res == EncodingUnsolvable) {
+        cout << "Verification problem proven UNSOLVABLE via reachability analysis." << endl;
+        return 2;
+    }
+    if (res == EncodingFailed) {
+        cerr << "Iteration " << iteration << " - Error: Encoding of the observations failed" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// returns 2 if the planner proved the observation-enforcing problem unsolvable
+int PosteriorDriver::selectHypothesis(const ParsedLog& obsLog, string& hypothesis, string& goal) {
+    TRACE_SCOPE("select_hypothesis");
+    if (isProvenUnsolvable(obsLog)) {
+        TRACE_ARG("proven_unsolvable", 1);
+#ifdef DEBUG
+        cout << "Plan generation failed with 'Proven unsolvable'. No hypothesis left to select." << endl;
+#endif
+        return 2;
+    }
+
+    if (config.style == TltWrapper) {
+        if (!extractTopLevelHypothesis(obsLog, hypothesis)) {
+            cerr << "Iteration " << iteration << " - Error: No __top[] -> line found in log file" << endl;
+            return 1;
+        }
+        goal = hypothesisToPredicate(hypothesis);
+    } else {
+        hypothesis = extractHypothesisFromLog(obsLog);
+        goal = extractInstantiatedSubtasks(obsLog);
+        if (goal.empty()) {
+            // fall back to the hypothesis task itself
+            goal = hypothesis;
+        }
+    }
+
+    if (hypothesis.empty() || goal.empty()) {
+        cerr << "Iteration " << iteration << " - Error: Could not extract hypothesis from log" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+double PosteriorDriver::baselineLogLikelihood(int iter, const string& domain, const string& goal, const ParsedLog& obsLog,
+                                              HypothesisRecord& record) const {
+    TRACE_SCOPE("baseline");
+    TRACE_ARG("iteration", iter);
+    string baselineProblem = iterationFile(iter, "_baseline_problem.hddl");
+    string content;
+    if (!problemDocument.withGoalTasks(goal, content)) {
+        cerr << "Iteration " << iter << " - Error: No :htn :tasks in problem file: " << config.problemFile << endl;
+        return -INFINITY;
+    }
+    if (!writeTextFile(baselineProblem, content)) {
+        cerr << "Iteration " << iter << " - Error: Cannot write baseline problem: " << baselineProblem << endl;
+        return -INFINITY;
+    }
+
+    string baselinePsas;
+    ParsedLog baselineLog;
+    string key = baselineCache.enabled() ? baselineCache.key(domain, baselineProblem) : "";
+    if (!key.empty() && baselineCache.lookup(key, baselinePsas, baselineLog)) {
+        TRACE_ARG("cache_hit", 1);
+#ifdef DEBUG
+        cout << "Iteration " << iter << " - Baseline solution found in the cache (" << key << ")" << endl;
+#endif
+    } else {
+        // the cache is filled from the log file
+        string logFile = iterationFile(iter, "_baseline.log");
+        if (ground(iter, domain, baselineProblem, "_baseline", baselinePsas) != 0
+            || solve(baselinePsas, logFile, baselineLog, !key.empty()) != 0) {
+            TRACE_ARG("failed", 1);
+#ifdef DEBUG
+            cout << "Iteration " << iter << " - Baseline planning failed, hypothesis may be unsolvable - setting likelihood to 0" << endl;
+#endif
+            return -INFINITY;
+        }
+        if (!key.empty()) {
+            if (!baselineLog.plan.empty()) {
+                baselineCache.store(key, baselinePsas, logFile);
+            }
+            if (!config.plannerLogs) {
+                remove(logFile.c_str());
+            }
+        }
+    }
+
+    // the detailed computation goes to the iteration's likelihood file
+    ofstream likelihoodOut(iterationFile(iter, "_likelihoods.txt"));
+    LikelihoodOptions options = config.likelihood;
+    options.log = &likelihoodOut;
+
+    Model* htn = new Model();
+    loadModel(htn, baselinePsas);
+    LikelihoodResult res = computeNormalizedLikelihood(htn, obsLog, baselineLog, options);
+    if (res.ok) {
+        record.logLikelihoodWithoutStage3 = res.logObsStage1 + res.logObsStage2 - res.logDenominator;
+        record.planSymbols.clear();
+        for (int a : planToActionIds(htn, obsLog)) {
+            record.planSymbols.push_back(SymbolTable::global().intern(htn->taskNames[a]));
+        }
+    }
+    delete htn;
+
+    if (!res.ok) {
+        cerr << "Iteration " << iter << " - Error: Failed to compute likelihood, see " << iterationFile(iter, "_likelihoods.txt") << endl;
+        return -INFINITY;
+    }
+    return res.logLikelihood;
+}
+
+int PosteriorDriver::removeHypothesis(const string& hypothesis) {
+    TRACE_SCOPE("remove_hypothesis");
+    if (config.groundOnce) {
+        // the hypothesis methods only decompose tlt/mtlt, the baselines can stay on the original domain
+        string method = (config.style == TltWrapper) ? topLevelMethodName(hypothesis) : hypothesis;
+        int disabled = method.empty() ? 0 : observationModel->disableMethodsByName(method);
+        TRACE_ARG("disabled_methods", disabled);
+        if (disabled == 0) {
+            // it would be selected again in the next iteration
+            cerr << "Iteration " << iteration << " - Error: No grounded method found for hypothesis " << hypothesis << endl;
+            return 1;
+        }
+#ifdef DEBUG
+        cout << "Disabled " << disabled << " grounded method(s) of " << method << endl;
+#endif
+        return 0;
+    }
+
+    // every reduced domain is emitted from the original one with all removed methods
+    string method = (config.style == TltWrapper) ? topLevelMethodName(hypothesis) : hypothesis;
+    if (method.empty()) {
+        cerr << "Iteration " << iteration << " - Error: No grounded top-level task in hypothesis: " << hypothesis << endl;
+        return 1;
+    }
+    removedMethods.push_back(method);
+    string reduced = iterationFile("_domain_reduced.hddl");
+    string content = (config.style == TltWrapper) ? domainDocument.withMethodsRemoved(removedMethods)
+                                                  : domainDocument.withMethodsCommented(removedMethods, removedMethodPrefix);
+    if (!writeTextFile(reduced, content)) {
+        cerr << "Iteration " << iteration << " - Error: Failed to remove hypothesis " << hypothesis << " from domain" << endl;
+        return 1;
+    }
+    currentDomain = reduced;
+    return 0;
+}
+
+void PosteriorDriver::removeIterationFiles() const {
+    DIR* dir = opendir(runDir.c_str());
+    if (dir == nullptr) return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        string name = entry->d_name;
+        if (!name.empty() && isdigit(name[0])) {
+            remove((runDir + name).c_str());
+        }
+    }
+    closedir(dir);
+}
+
+// ============================================================================
+// MAIN LOOP
+// ============================================================================
+
+int PosteriorDriver::run() {
+    results.clear();
+    if (prepare() != 0) {
+        return 1;
+    }
+
+    int status = selectHypotheses();
+    printTimes();
+    if (!config.keepFiles) {
+        removeIterationFiles();
+    }
+    return status;
+}
+
+int PosteriorDriver::sweep(int firstObs, int lastObs) {
+    sweepResults.clear();
+    if (prepare() != 0) {
+        return 1;
+    }
+    int numObservations = observations.size();
+    if ((lastObs < 0) || (lastObs > numObservations)) {
+        lastObs = numObservations;
+    }
+    bool likelihoodFollowsPrefix = (config.likelihood.numObservations >= 0);
+
+    int status = 0;
+    for (int n = max(firstObs, 0); n <= lastObs; n++) {
+        cout << "==================== Observations: " << n << "/" << numObservations << " ====================" << endl;
+        numObsUsed = n;
+        if (likelihoodFollowsPrefix) {
+            config.likelihood.numObservations = n;
+        }
+        runDir = config.workDir + "obs_" + to_string(n) + "/";
+        if (!makeDirectories(runDir)) {
+            cerr << "Error: Cannot create work directory: " << runDir << endl;
+            status = 1;
+            break;
+        }
+        restoreHypotheses();
+
+        int ret = selectHypotheses();
+        printTimes();
+        writeLikelihoods(runDir + "likelihoods.txt");
+        writePosteriors(runDir + "posteriors.txt");
+        if (!config.keepFiles) {
+            removeIterationFiles();
+        }
+
+        SweepPoint point;
+        point.numObs = n;
+        point.results = results;
+        sweepResults.push_back(point);
+        if (ret != 0) {
+            status = ret;
+        }
+    }
+    runDir = config.workDir;
+    return status;
+}
+
+int PosteriorDriver::serve(istream& in, ostream& out) {
+    // new observations are mapped to the actions of the resident model
+    if (!config.groundOnce) {
+        cerr << "Error: serve keeps the grounded model loaded, it cannot be used with --reground" << endl;
+        return 1;
+    }
+    results.clear();
+    if (prepare() != 0) {
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    int status = searchServed();
+    writeServed(out, "searched", chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+    string line;
+    while (getline(in, line)) {
+        string text = trim(line);
+        if (text.empty()) {
+            continue;
+        }
+        if (text == "quit") {
+            break;
+        }
+        start = chrono::steady_clock::now();
+
+        vector<string> added;
+        istringstream lineIn(text);
+        encoder.readSolution(lineIn, added, -1);
+        vector<int> addedIds;
+        if ((observationModel != nullptr) && !encoder.mapPlan(observationModel, added, addedIds)) {
+            out << "error unknown action: " << text << endl << endl;
+            continue;
+        }
+        observations.insert(observations.end(), added.begin(), added.end());
+
+        // without a model the last search failed before grounding, it maps all observations again
+        bool search = (observationModel == nullptr);
+        if (!search) {
+            observationIds.insert(observationIds.end(), addedIds.begin(), addedIds.end());
+            for (int a : addedIds) {
+                if ((a >= 0) && !addServedObservation(SymbolTable::global().intern(observationModel->taskNames[a]))) {
+                    search = true;
+                }
+            }
+        }
+        if (search) {
+            status = searchServed();
+        } else {
+            rescoreServed();
+        }
+        writeServed(out, search ? "searched" : "rescored", chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    return status;
+}
+
+// the selection for all observations so far
+int PosteriorDriver::searchServed() {
+    restoreHypotheses();
+    numObsUsed = -1;
+    config.likelihood.numObservations = observations.size();
+    int status = selectHypotheses();
+
+    observationSymbols.clear();
+    if (observationModel != nullptr) {
+        for (int a : observationIds) {
+            if (a >= 0) {
+                observationSymbols.push_back(SymbolTable::global().intern(observationModel->taskNames[a]));
+            }
+        }
+    }
+    servedStage3.clear();
+    servedScores.clear();
+    for (const HypothesisRecord& r : results) {
+        servedStage3.emplace_back(r.planSymbols, config.likelihood.fullObservability, config.likelihood.pDet);
+        for (int o : observationSymbols) {
+            servedStage3.back().addObservation(o);
+        }
+        servedScores.emplace_back(r.planSymbols, config.likelihood.fullObservability, config.likelihood.pDet);
+    }
+    rescoreServed();
+    return status;
+}
+
+// false if the observation makes a plan inconsistent that explained the ones before
+bool PosteriorDriver::addServedObservation(int symbol) {
+    observationSymbols.push_back(symbol);
+    bool consistent = true;
+    for (IncrementalStage3& stage3 : servedStage3) {
+        bool before = stage3.consistent();
+        stage3.addObservation(symbol);
+        if (before && !stage3.consistent()) {
+            consistent = false;
+        }
+    }
+    return consistent;
+}
+
+// the scores follow stage3Observations of the plan for the observations so far
+void PosteriorDriver::extendServedScores() {
+    config.likelihood.numObservations = observations.size();
+    for (size_t i = 0; i < results.size(); i++) {
+        const vector<int>& plan = results[i].planSymbols;
+        int n = stage3Observations(plan, config.likelihood.numObservations).size();
+        while (servedScores[i].numObservations() < n) {
+            servedScores[i].addObservation(plan[servedScores[i].numObservations()]);
+        }
+    }
+}
+
+void PosteriorDriver::rescoreServed() {
+    extendServedScores();
+    for (size_t i = 0; i < results.size(); i++) {
+        HypothesisRecord& r = results[i];
+        r.logLikelihood = r.planSymbols.empty() ? -INFINITY : r.logLikelihoodWithoutStage3 + servedScores[i].logProbability();
+        r.likelihood = exp(r.logLikelihood);
+    }
+}
+
+int PosteriorDriver::selectHypotheses() {
+    results.clear();
+    iterationsSaved = 0;
+    stopMessage.clear();
+    // the jobs write into results while the selection appends to it
+    results.reserve(max(config.kIterations, 0));
+
+    auto run_start = chrono::high_resolution_clock::now();
+    WorkerPool pool(config.workers > 1 ? config.workers : 0);
+    deque<shared_ptr<ParsedLog>> pending; // solutions of the last observation search not used yet
+    set<string> selected;
+    int status = 0;
+    for (iteration = 1; iteration <= config.kIterations; iteration++) {
+        TRACE_SCOPE("iteration");
+        TRACE_ARG("iteration", iteration);
+        cout << "==================== Iteration " << iteration << " ====================" << endl;
+        auto start_time = chrono::high_resolution_clock::now();
+
+        HypothesisRecord record;
+        record.iteration = iteration;
+        string goal;
+        shared_ptr<ParsedLog> obsLog;
+
+        // further solutions of the last search come first
+        while (!pending.empty() && (obsLog == nullptr)) {
+            shared_ptr<ParsedLog> log = pending.front();
+            pending.pop_front();
+            if ((selectHypothesis(*log, record.hypothesis, goal) == 0) && (selected.count(record.hypothesis) == 0)) {
+                obsLog = log;
+                TRACE_ARG("further_solution", 1);
+#ifdef DEBUG
+                cout << "Hypothesis taken from a further solution of the last observation search" << endl;
+#endif
+            }
+        }
+
+        if (obsLog == nullptr) {
+            if ((!config.groundOnce || (observationModel == nullptr)) && (loadObservationModel() != 0)) {
+                status = 1;
+                break;
+            }
+
+            string pgr = iterationFile("_obs.pgr");
+            int ret = encodeObservations(pgr);
+            if (ret != 0) {
+                status = (ret == 2) ? 0 : 1;
+                break;
+            }
+
+            // read once, used by the selection and the baseline job
+            vector<ParsedLog> logs;
+            // a planner that proved the problem unsolvable may exit with a failure, there is no hypothesis left then
+            if (solveObservations(pgr, logs) != 0 && !isProvenUnsolvable(logs[0])) {
+                cerr << "Iteration " << iteration << " - Error: Planning the observations failed"
+                     << (config.plannerLogs ? ", see " + iterationFile("_obs_pgr.log") : "") << endl;
+                status = 1;
+                break;
+            }
+            obsLog = make_shared<ParsedLog>(move(logs[0]));
+            for (size_t i = 1; i < logs.size(); i++) {
+                pending.push_back(make_shared<ParsedLog>(move(logs[i])));
+            }
+            TRACE_COUNTER("pending_solutions", pending.size());
+
+            ret = selectHypothesis(*obsLog, record.hypothesis, goal);
+            if (ret != 0) {
+                status = (ret == 2) ? 0 : 1;
+                break;
+            }
+        }
+        selected.insert(record.hypothesis);
+#ifdef DEBUG
+        cout << "Selected hypothesis: " << record.hypothesis << endl;
+        cout << "Baseline goal: " << goal << endl;
+#endif
+
+        auto end_time = chrono::high_resolution_clock::now();
+        record.seconds = chrono::duration<double>(end_time - start_time).count();
+        size_t index;
+        {
+            lock_guard<mutex> guard(resultsLock);
+            index = results.size();
+            results.push_back(record);
+        }
+
+        // the domain is copied, the next selection may already reduce it
+        string domain = currentDomain;
+        int iter = iteration;
+        pool.submit([this, index, iter, domain, goal, obsLog]() {
+            auto baseline_start = chrono::high_resolution_clock::now();
+            HypothesisRecord scored;
+            double logLikelihood = baselineLogLikelihood(iter, domain, goal, *obsLog, scored);
+            auto baseline_end = chrono::high_resolution_clock::now();
+
+            lock_guard<mutex> guard(resultsLock);
+            HypothesisRecord& r = results[index];
+            r.logLikelihood = logLikelihood;
+            r.logLikelihoodWithoutStage3 = scored.logLikelihoodWithoutStage3;
+            r.planSymbols = move(scored.planSymbols);
+            r.likelihood = exp(logLikelihood);
+            r.seconds += chrono::duration<double>(baseline_end - baseline_start).count();
+
+            ostringstream report;
+            report << "Likelihood: " << scientific << setprecision(10) << r.likelihood << endl;
+            report.unsetf(ios::floatfield);
+            report << "Iteration " << iter << " took " << r.seconds << " seconds" << endl;
+            cout << report.str() << flush;
+        });
+
+        if (removeHypothesis(record.hypothesis) != 0) {
+            status = 1;
+            break;
+        }
+
+        if ((config.stopEpsilon > 0.0) || config.stopOnTop) {
+            pool.wait();
+            stopMessage = stopReason();
+            if (!stopMessage.empty()) {
+                iterationsSaved = config.kIterations - iteration;
+                TRACE_COUNTER("iterations_saved", iterationsSaved);
+                cout << "Stopping after iteration " << iteration << " of " << config.kIterations << ": " << stopMessage << endl;
+                break;
+            }
+        }
+    }
+    pool.wait();
+#ifdef TRACEPIPELINE
+    // one trace per run (per prefix length in a sweep)
+    if (!Trace::global().write(runDir + "trace.json")) {
+        cerr << "Warning: Cannot write trace: " << runDir << "trace.json" << endl;
+    }
+    Trace::global().clear();
+#endif
+
+    if (pool.size() > 0) {
+        auto run_end = chrono::high_resolution_clock::now();
+        cout << "Wall Time: " << chrono::duration<double>(run_end - run_start).count()
+             << " seconds (" << pool.size() << " baseline workers)" << endl;
+    }
+    return status;
+}
+
+// The kIterations - iteration hypotheses that are still to be selected have a
+// likelihood of at most exp(config.stopLogBound) each, their mass
+// R <= remaining * exp(bound).
+// Normalizing with them scales the posteriors found so far by S / (S + R), so
+// no posterior moves by more than R / (S + R), and none of them outranks the
+// top-ranked hypothesis if bound is below its likelihood.
+string PosteriorDriver::stopReason() {
+    int remaining = config.kIterations - iteration;
+    if (remaining <= 0) {
+        return "";
+    }
+    double bound = config.stopLogBound;
+    double top = -INFINITY;
+    vector<double> found;
+    {
+        lock_guard<mutex> guard(resultsLock);
+        for (const HypothesisRecord& r : results) {
+            found.push_back(r.logLikelihood);
+            top = max(top, r.logLikelihood);
+        }
+    }
+    if (!std::isfinite(bound) || (top == -INFINITY)) {
+        return "";
+    }
+
+    double logRemaining = log((double) remaining) + bound;
+    double logFound = logSumExp(found);
+    double logShift = logRemaining - logSumExp({logFound, logRemaining});
+    ostringstream reason;
+    if (config.stopOnTop && (bound < top)) {
+        reason << "no remaining hypothesis can outrank the top-ranked one (log likelihood bound "
+               << bound << " < " << top << ")";
+    } else if ((config.stopEpsilon > 0.0) && (logShift < log(config.stopEpsilon))) {
+        reason << "the remaining hypotheses move no posterior by more than " << exp(logShift)
+               << " < " << config.stopEpsilon;
+    }
+    return reason.str();
+}
+
+void PosteriorDriver::printTimes() const {
+    cout << "==================== Time per Iteration ====================" << endl;
+    double total_time = 0.0;
+    for (const HypothesisRecord& r : results) {
+        cout << "Iteration " << r.iteration << ": " << r.seconds << " seconds" << endl;
+        total_time += r.seconds;
+    }
+    cout << "Total Time: " << total_time << " seconds" << endl;
+    if (iterationsSaved > 0) {
+        cout << "Iterations saved: " << iterationsSaved << " of " << config.kIterations << " (" << stopMessage << ")" << endl;
+    }
+}
+
+// ============================================================================
+// RESULT FILES
+// ============================================================================
+
+// posteriors under a uniform prior, normalized in log space
+static vector<double> posteriorsOf(const vector<HypothesisRecord>& records, double& likelihoodSum) {
+    vector<double> logLikelihoods;
+    for (const HypothesisRecord& r : records) {
+        logLikelihoods.push_back(r.logLikelihood);
+    }
+    likelihoodSum = exp(logSumExp(logLikelihoods));
+    vector<double> posteriors = normalizeLogLikelihoods(logLikelihoods);
+    for (double& p : posteriors) {
+        p = exp(p);
+    }
+    return posteriors;
+}
+
+bool PosteriorDriver::writeLikelihoods(const string& file) const {
+    ofstream out(file);
+    if (!out.is_open()) {
+        cerr << "Error: Cannot write to output file: " << file << endl;
+        return false;
+    }
+    for (const HypothesisRecord& r : results) {
+        out << r.hypothesis << " " << scientific << setprecision(10) << r.likelihood << endl;
+    }
+    return true;
+}
+
+bool PosteriorDriver::writePosteriors(const string& file) const {
+    ofstream out(file);
+    if (!out.is_open()) {
+        cerr << "Error: Cannot write to output file: " << file << endl;
+        return false;
+    }
+
+    double likelihoodSum;
+    vector<double> posteriors = posteriorsOf(results, likelihoodSum);
+
+    vector<pair<string, pair<double, double>>> ranked;
+    for (size_t i = 0; i < results.size(); i++) {
+        ranked.push_back({results[i].hypothesis, {results[i].likelihood, posteriors[i]}});
+    }
+    stable_sort(ranked.begin(), ranked.end(), [](const pair<string, pair<double, double>>& a,
+                                                 const pair<string, pair<double, double>>& b) {
+        return a.second.second > b.second.second;
+    });
+
+    out << "# Normalized Posterior Probabilities" << endl;
+    out << "# Format: hypothesis_name likelihood posterior" << endl;
+    out << "# Likelihood sum: " << scientific << setprecision(10) << likelihoodSum << endl;
+    out << "#" << endl;
+    for (const auto& entry : ranked) {
+        out << entry.first << " "
+            << scientific << setprecision(10) << entry.second.first << " "
+            << scientific << setprecision(10) << entry.second.second << endl;
+    }
+    return true;
+}
+
+// "update <num_obs> searched|rescored <ms> ms", then "hypothesis likelihood posterior" sorted by posterior and an empty line
+void PosteriorDriver::writeServed(ostream& out, const string& update, double seconds) const {
+    double likelihoodSum;
+    vector<double> posteriors = posteriorsOf(results, likelihoodSum);
+    vector<size_t> ranked;
+    for (size_t i = 0; i < results.size(); i++) {
+        ranked.push_back(i);
+    }
+    stable_sort(ranked.begin(), ranked.end(), [&posteriors](size_t a, size_t b) {
+        return posteriors[a] > posteriors[b];
+    });
+
+    out << "update " << observations.size() << " " << update << " " << fixed << setprecision(3) << seconds * 1000 << " ms" << endl;
+    for (size_t i : ranked) {
+        out << results[i].hypothesis << " "
+            << scientific << setprecision(10) << results[i].likelihood << " "
+            << scientific << setprecision(10) << posteriors[i] << endl;
+    }
+    out << endl;
+    out.unsetf(ios::floatfield);
+}
+
+bool PosteriorDriver::writeSummary(const string& file) const {
+    ofstream outFile(file, ios::app);
+    if (!outFile.is_open()) {
+        cerr << "Error: Cannot write to output file: " << file << endl;
+        return false;
+    }
+
+    // hypotheses are unique per run since each one is removed after its selection
+    map<string, double> likelihoods;
+    map<string, double> logLikelihoods;
+    for (const HypothesisRecord& r : results) {
+        likelihoods[r.hypothesis] = r.likelihood;
+        logLikelihoods[r.hypothesis] = r.logLikelihood;
+    }
+
+    outFile << "============================================================" << endl;
+    outFile << "Results by Iteration Order (Discovery Order)" << endl;
+    outFile << "============================================================" << endl;
+    outFile << endl;
+    if (iterationsSaved > 0) {
+        outFile << "Stopped after " << results.size() << " of " << config.kIterations << " iterations: " << stopMessage << endl;
+        outFile << endl;
+    }
+
+    for (size_t i = 0; i < results.size(); i++) {
+        outFile << "Iteration " << (i + 1) << ": " << results[i].hypothesis << endl;
+        outFile << "  Likelihood: " << scientific << setprecision(10) << results[i].likelihood << endl;
+        outFile << endl;
+    }
+
+    vector<double> logValues;
+    for (const auto& entry : logLikelihoods) {
+        logValues.push_back(entry.second);
+    }
+    vector<double> logPosteriors = normalizeLogLikelihoods(logValues);
+
+    vector<pair<string, double>> ranked;
+    ranked.reserve(likelihoods.size());
+    size_t k = 0;
+    for (const auto& entry : logLikelihoods) {
+        ranked.push_back({entry.first, exp(logPosteriors[k++])});
+    }
+
+    stable_sort(ranked.begin(), ranked.end(), [](const pair<string, double>& a, const pair<string, double>& b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+
+    outFile << "============================================================" << endl;
+    outFile << "Results Ranked by Posterior (Sorted by Probability)" << endl;
+    outFile << "============================================================" << endl;
+    outFile << endl;
+
+    for (size_t i = 0; i < ranked.size(); i++) {
+        const string& hypothesis = ranked[i].first;
+        outFile << "Rank " << (i + 1) << ": " << hypothesis << endl;
+        outFile << "  Likelihood: " << scientific << setprecision(10) << likelihoods[hypothesis] << endl;
+        outFile << "  Posterior:  " << scientific << setprecision(10) << ranked[i].second << endl;
+        outFile << endl;
+    }
+    return true;
+}
+
+bool PosteriorDriver::writeCurve(const string& file) const {
+    ofstream out(file);
+    if (!out.is_open()) {
+        cerr << "Error: Cannot write to output file: " << file << endl;
+        return false;
+    }
+
+    out << "# Posterior per number of observations" << endl;
+    out << "# Format: num_obs hypothesis_name likelihood posterior" << endl;
+    for (const SweepPoint& point : sweepResults) {
+        double likelihoodSum;
+        vector<double> posteriors = posteriorsOf(point.results, likelihoodSum);
+        for (size_t i = 0; i < point.results.size(); i++) {
+            const HypothesisRecord& r = point.results[i];
+            out << point.numObs << " " << r.hypothesis << " "
+                << scientific << setprecision(10) << r.likelihood << " "
+                << scientific << setprecision(10) << posteriors[i] << endl;
+        }
+    }
+    return true;
+}
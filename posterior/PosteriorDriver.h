@@ -0,0 +1,216 @@
+/**
+ * In-process posterior estimation via iterative hypothesis selection
+ *
+ * One run performs k iterations of
+ *   1. parse and ground the observation-enforcing problem
+ *   2. encode the observations into a PGR problem (GroundPrefixEncoding)
+ *   3. solve it with pplanner and extract the selected hypothesis
+ *   4. solve the baseline problem for that hypothesis
+ *   5. compute the normalized likelihood (NormalizedLikelihood)
+ *   6. remove the hypothesis from the domain
+ *
+ * Only the PANDA parser, grounder and planner are run as external tools; the
+ * models, the encoding, the planner logs and the likelihood computation stay
+ * in this process.
+ *
+ * By default (groundOnce) step 1 is only done in the first iteration: the
+ * grounded model is kept and step 6 disables the methods of the selected
+ * hypothesis in it (Model::disableMethodsByName) instead of rewriting the
+ * domain file.
+ *
+ * With solutionsPerSearch > 1, step 3 takes several hypotheses from one
+ * search: a planner that is told to continue after a solution (see
+ * plannerOptions) reports further plans with other top-level methods, and
+ * these are selected one per iteration, in the order the planner found them
+ * and skipping repeated ones, before the masked problem is solved again. The
+ * planner does not see the masking of these hypotheses, so the order may
+ * differ from the one of single-solution searches.
+ *
+ * The baseline of step 4 does not depend on the observations either; with a
+ * baselineCacheDir its solution is stored and reused by later iterations,
+ * prefix lengths and runs (see BaselineCache.h). With a groundingCacheDir
+ * the grounded models of steps 2 to 4 are shared the same way (see
+ * GroundingCache.h).
+ *
+ * Steps 4 and 5 only depend on the selected hypothesis. With workers > 1 they
+ * are handed to a WorkerPool while the selection continues with the next
+ * iteration; the results are still reported in discovery order.
+ *
+ * With stopEpsilon > 0 or stopOnTop the selection may end before kIterations
+ * (see PosteriorDriver::stopReason()): every hypothesis not found yet is
+ * assumed to have a likelihood of at most the bound stopLogBound. The bound
+ * has to be given; the likelihoods found so far give none, although the
+ * planner finds the cheapest solutions first, each likelihood is normalized
+ * by the baseline of its own hypothesis. Without it stopping is disabled.
+ *
+ * sweep() repeats the selection for a range of observation prefix lengths.
+ * The observation problem, the observations, their mapping to action ids and
+ * (with groundOnce) the grounded model are shared by all prefixes, each prefix
+ * length n gets its own directory obs_<n> in the work directory.
+ *
+ * serve() keeps all of this resident for observations that arrive one at a
+ * time. The likelihood of a selected hypothesis only depends on the
+ * observations through Stage III, so every new observation extends the
+ * Stage III of the plans found so far (IncrementalStage3) and the posterior
+ * is normalized again. Stage III is computed as in run() with num_obs set to
+ * the number of observations so far (stage3Observations), so an update
+ * gives the posterior of a fresh run on the same observations. Only when a
+ * plan can no longer produce the observations is the selection run again,
+ * for all observations so far; the grounded model stays loaded (groundOnce,
+ * serve() fails without it) and the baselines come from the cache.
+ */
+
+#ifndef POSTERIORDRIVER_H_
+#define POSTERIORDRIVER_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include "../htnModel/Model.h"
+#include "../prefEncoding/GroundPrefixEncoding.h"
+#include "../likelihood/NormalizedLikelihood.h"
+#include "BaselineCache.h"
+#include "GroundingCache.h"
+#include "HddlDocument.h"
+
+using namespace std;
+using namespace progression;
+
+// TltWrapper: Monroe-style domains, the problem has a commented (tlt) task and
+//             the goals are reached via m-tlt-<task> methods
+// ExplicitHypotheses: kitchen-style domains with "(:method hypothesis-N" methods
+enum domainStyle {TltWrapper, ExplicitHypotheses};
+
+struct DriverConfig {
+    string domainFile;
+    string problemFile;
+    string observationFile;
+    int numObs = -1;                // observations given to the encoder, -1 = all
+    int kIterations = 5;
+    string workDir = ".";
+    string toolDir = ".";           // location of pandaPIparser, pandaPIgrounder and pplanner
+    domainStyle style = TltWrapper;
+    encodingType encoding = PGRfo;
+    LikelihoodOptions likelihood;
+    bool keepFiles = true;          // keep the per-iteration files (prefixed with the iteration number)
+    bool plannerLogs = true;        // write the planner logs (_obs_pgr.log, _baseline.log), they are parsed from a pipe either way
+    bool groundOnce = true;         // mask hypotheses in the grounded model instead of regrounding a reduced domain
+    int workers = 1;                // parallel baseline/likelihood jobs, 1 = within the selection loop
+    int solutionsPerSearch = 1;     // hypotheses taken from one observation search, at most
+    vector<string> plannerOptions;  // further pplanner arguments for the observation search
+    string modelCacheDir;           // binary cache for the grounded models (Model::readCached), empty = none
+    string baselineCacheDir;        // solved baseline problems (BaselineCache), empty = none
+    string groundingCacheDir;       // grounded models by domain and problem (GroundingCache), empty = none
+    // adaptive stopping, the likelihood of an iteration is awaited before the next one (also with workers > 1)
+    double stopEpsilon = 0.0;       // stop once the remaining hypotheses move no posterior by epsilon or more, 0 = off
+    bool stopOnTop = false;         // stop once the remaining hypotheses cannot outrank the top-ranked one
+    double stopLogBound = NAN;      // log likelihood bound of the remaining hypotheses, required by both
+};
+
+struct HypothesisRecord {
+    int iteration = 0;
+    string hypothesis;
+    double likelihood = 0.0;
+    double logLikelihood = -INFINITY; // the posteriors are normalized from this one
+    double seconds = 0.0;
+    // rescoring in serve(): the log likelihood without the observation Stage III and the plan π^+ (SymbolTable)
+    double logLikelihoodWithoutStage3 = -INFINITY;
+    vector<int> planSymbols;
+};
+
+struct SweepPoint {
+    int numObs = 0;
+    vector<HypothesisRecord> results;
+};
+
+// ExplicitHypotheses if the domain defines "(:method hypothesis-" methods
+domainStyle detectDomainStyle(const string& domainFile);
+
+class PosteriorDriver {
+public:
+    PosteriorDriver(const DriverConfig& config);
+    ~PosteriorDriver();
+    PosteriorDriver(const PosteriorDriver&) = delete;
+    PosteriorDriver& operator=(const PosteriorDriver&) = delete;
+
+    // returns 0 if all iterations ran or the hypotheses were exhausted
+    int run();
+    // run() for the prefix lengths firstObs..lastObs (-1 = all observations);
+    // a non-negative likelihood.numObservations follows the prefix length
+    int sweep(int firstObs, int lastObs);
+    // run() for the observation file, then one update per line of in (actions
+    // as in an observation file, "quit" ends); the posterior after every update
+    // goes to out
+    int serve(istream& in, ostream& out);
+
+    const vector<HypothesisRecord>& getResults() const;
+    const vector<SweepPoint>& getSweepResults() const;
+    // iterations of the last selection that were not run because of adaptive stopping
+    int getIterationsSaved() const;
+
+    // "hypothesis likelihood" per line in discovery order (input of compute_posterior)
+    bool writeLikelihoods(const string& file) const;
+    // same format as compute_posterior, sorted by posterior
+    bool writePosteriors(const string& file) const;
+    // discovery order and ranking, appended to file
+    bool writeSummary(const string& file) const;
+    // "num_obs hypothesis likelihood posterior" for every prefix length of the sweep
+    bool writeCurve(const string& file) const;
+
+private:
+    DriverConfig config;
+    GroundPrefixEncoding encoder;
+    BaselineCache baselineCache;
+    GroundingCache groundingCache;
+
+    string observationProblem;      // mtlt/tlt version of the problem
+    string currentDomain;           // domain with the hypotheses selected so far removed
+    HddlDocument domainDocument;    // config.domainFile and config.problemFile, parsed once
+    HddlDocument problemDocument;
+    vector<string> removedMethods;  // methods of the hypotheses removed from currentDomain
+    Model* observationModel = nullptr; // grounded observation problem, hypotheses masked (groundOnce)
+    vector<string> observations;    // the whole observation file
+    vector<int> observationIds;     // observations mapped to the actions of observationModel
+    int numObsUsed = -1;            // observations given to the encoder, -1 = all
+    string runDir;                  // work directory of the current prefix length
+    vector<HypothesisRecord> results;
+    vector<SweepPoint> sweepResults;
+    vector<int> observationSymbols; // serve(): the actions of the observations so far (SymbolTable)
+    vector<IncrementalStage3> servedStage3; // serve(): the plan of every result against the observations, for consistency
+    vector<IncrementalStage3> servedScores; // serve(): Stage III of every result as scored (stage3Observations)
+    mutex resultsLock;              // results and console output shared with the baseline jobs
+    int iteration = 0;
+    int iterationsSaved = 0;
+    string stopMessage;             // why the last selection stopped early
+
+    string iterationFile(const string& suffix) const;
+    string iterationFile(int iter, const string& suffix) const;
+    string tool(const string& name) const;
+    void loadModel(Model* htn, const string& psas) const;
+
+    int prepare();
+    void restoreHypotheses();
+    int selectHypotheses();
+    string stopReason();
+    int searchServed();
+    bool addServedObservation(int symbol);
+    void rescoreServed();
+    void extendServedScores();
+    void writeServed(ostream& out, const string& update, double seconds) const;
+    void printTimes() const;
+    int ground(int iter, const string& domain, const string& problem, const string& prefix, string& psas) const;
+    int solve(const string& input, const string& logFile, ParsedLog& log, bool keepLog = false) const;
+    int solveObservations(const string& pgr, vector<ParsedLog>& logs) const;
+    int loadObservationModel();
+    int encodeObservations(const string& pgr);
+    int selectHypothesis(const ParsedLog& obsLog, string& hypothesis, string& goal);
+    // thread-safe for different iterations
+    // log likelihood of the hypothesis, -inf if the baseline or the computation fails;
+    // the parts serve() rescores go to record (logLikelihoodWithoutStage3, planSymbols)
+    double baselineLogLikelihood(int iter, const string& domain, const string& goal, const ParsedLog& obsLog,
+                                 HypothesisRecord& record) const;
+    int removeHypothesis(const string& hypothesis);
+    void removeIterationFiles() const;
+};
+
+#endif /* POSTERIORDRIVER_H_ */
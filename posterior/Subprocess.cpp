@@ -0,0 +1,275 @@
+/**
+ * Running the external PANDA tools without going through a shell
+ */
+
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <chrono>
+#include <thread>
+#include "Subprocess.h"
+
+// output file of a tool (/dev/null if empty), -1 if it cannot be opened
+static int openOutput(const string& outputFile, bool append) {
+    // close-on-exec: tools started concurrently from other threads must not inherit it
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    if (!append && !outputFile.empty()) {
+        // a new file: hard links to the old one (publishFile) keep their content
+        unlink(outputFile.c_str());
+    }
+    int fd = open(outputFile.empty() ? "/dev/null" : outputFile.c_str(), flags, 0644);
+    if (fd < 0) {
+        cerr << "Error: Cannot open output file: " << outputFile << endl;
+    }
+    return fd;
+}
+
+// forks the tool with stdout and stderr redirected to fd, returns its pid or -1
+static pid_t startTool(const vector<string>& args, int fd, const ToolLimits* limits) {
+    if (args.empty()) {
+        return -1;
+    }
+
+    vector<char*> argv;
+    for (const string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    cout.flush();
+    cerr.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        cerr << "Error: Cannot start " << args[0] << endl;
+        return -1;
+    }
+    if (pid == 0) {
+        if (limits != nullptr) {
+            setpgid(0, 0);
+            if (limits->memoryLimitMB > 0) {
+                struct rlimit rl;
+                rl.rlim_cur = rl.rlim_max = (rlim_t) limits->memoryLimitMB * 1024 * 1024;
+                setrlimit(RLIMIT_AS, &rl);
+            }
+        }
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t startTool(const vector<string>& args, const string& outputFile, bool append, const ToolLimits* limits) {
+    if (args.empty()) {
+        return -1;
+    }
+    int fd = openOutput(outputFile, append);
+    if (fd < 0) {
+        return -1;
+    }
+    pid_t pid = startTool(args, fd, limits);
+    close(fd);
+    return pid;
+}
+
+static int waitForTool(pid_t pid) {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return status;
+}
+
+static int exitStatus(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return -1;
+}
+
+int runTool(const vector<string>& args, const string& outputFile, bool append) {
+    pid_t pid = startTool(args, outputFile, append, nullptr);
+    if (pid < 0) {
+        return -1;
+    }
+    int status = waitForTool(pid);
+    return (status < 0) ? -1 : exitStatus(status);
+}
+
+int runToolPiped(const vector<string>& args, const string& outputFile, const function<void(const char*, size_t)>& consume) {
+    if (args.empty()) {
+        return -1;
+    }
+    int fileFd = -1;
+    if (!outputFile.empty() && ((fileFd = openOutput(outputFile, false)) < 0)) {
+        return -1;
+    }
+    // close-on-exec as for the output file, a copy of the write end in
+    // another tool would keep the pipe open
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        cerr << "Error: Cannot create pipe for " << args[0] << endl;
+        if (fileFd >= 0) close(fileFd);
+        return -1;
+    }
+    pid_t pid = startTool(args, fds[1], nullptr);
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        if (fileFd >= 0) close(fileFd);
+        return -1;
+    }
+
+    char buffer[1 << 16];
+    while (true) {
+        ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        consume(buffer, n);
+        for (ssize_t written = 0; (fileFd >= 0) && (written < n); ) {
+            ssize_t w = write(fileFd, buffer + written, n - written);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) {
+                cerr << "Error: Cannot write output file: " << outputFile << endl;
+                close(fileFd);
+                fileFd = -1;
+                break;
+            }
+            written += w;
+        }
+    }
+    close(fds[0]);
+    if (fileFd >= 0) close(fileFd);
+
+    int status = waitForTool(pid);
+    return (status < 0) ? -1 : exitStatus(status);
+}
+
+static volatile sig_atomic_t caughtSignal = 0;
+
+static void onInterrupt(int sig) {
+    caughtSignal = sig;
+}
+
+void installInterruptHandler() {
+    struct sigaction action;
+    action.sa_handler = onInterrupt;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = 0;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+int interruptSignal() {
+    return caughtSignal;
+}
+
+ToolUsage runToolLimited(const vector<string>& args, const string& outputFile, const ToolLimits& limits) {
+    ToolUsage usage;
+    auto start = chrono::steady_clock::now();
+    pid_t pid = startTool(args, outputFile, false, &limits);
+    if (pid < 0) {
+        return usage;
+    }
+    // the child may not have reached setpgid yet when it has to be killed
+    setpgid(pid, pid);
+
+    int status = 0;
+    struct rusage ru;
+    while (true) {
+        pid_t ret = wait4(pid, &status, WNOHANG, &ru);
+        if (ret == pid) {
+            break;
+        }
+        if ((ret < 0) && (errno != EINTR)) {
+            return usage;
+        }
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if ((limits.timeLimit > 0) && (elapsed > limits.timeLimit) && !usage.timedOut) {
+            usage.timedOut = true;
+            kill(-pid, SIGKILL);
+        }
+        if ((caughtSignal != 0) && !usage.interrupted) {
+            usage.interrupted = true;
+            kill(-pid, SIGKILL);
+        }
+        this_thread::sleep_for(chrono::milliseconds(20));
+    }
+    if (usage.timedOut || usage.interrupted) {
+        // the tools started by the job may outlive it
+        kill(-pid, SIGKILL);
+    }
+
+    usage.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    usage.maxRssKB = ru.ru_maxrss;
+    usage.status = exitStatus(status);
+    return usage;
+}
+
+bool makeDirectories(const string& path) {
+    string current;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == string::npos) end = path.size();
+        current = path.substr(0, end);
+        start = end + 1;
+        if (current.empty()) continue;
+        if (mkdir(current.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static atomic<int> tmpFileCounter(0);
+
+bool publishFile(const string& source, const string& target) {
+    string tmp = target + ".tmp" + to_string(getpid()) + "." + to_string(tmpFileCounter++);
+    if (link(source.c_str(), tmp.c_str()) != 0) {
+        ifstream in(source, ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        ofstream out(tmp, ios::binary);
+        out << in.rdbuf();
+        out.close();
+        if (!out) {
+            remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), target.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+string toolStamp(const string& toolDir, const vector<string>& names) {
+    string stamp;
+    for (const string& name : names) {
+        struct stat st;
+        string path = toolDir + name;
+        if (stat(path.c_str(), &st) == 0) {
+            stamp += name + " " + to_string(st.st_size) + " " + to_string(st.st_mtime) + "\n";
+        }
+    }
+    return stamp;
+}
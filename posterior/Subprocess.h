@@ -0,0 +1,62 @@
+/**
+ * Running the external PANDA tools without going through a shell
+ */
+
+#ifndef SUBPROCESS_H_
+#define SUBPROCESS_H_
+
+#include <string>
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+// Runs args[0] with the given arguments. stdout and stderr are redirected to
+// outputFile (a new file, or appended if append is set); an empty outputFile
+// discards the output. Returns the exit status of the tool, or -1 if it could
+// not be started or was terminated by a signal.
+int runTool(const vector<string>& args, const string& outputFile, bool append = false);
+
+// runTool with stdout and stderr read through a pipe: consume gets the output
+// in pieces while the tool is running. It is written to outputFile as well
+// unless that is empty.
+int runToolPiped(const vector<string>& args, const string& outputFile, const function<void(const char*, size_t)>& consume);
+
+struct ToolLimits {
+    double timeLimit = 0.0;         // wall-clock seconds, 0 = unlimited
+    long memoryLimitMB = 0;         // address space per process, 0 = unlimited
+};
+
+struct ToolUsage {
+    int status = -1;                // as returned by runTool
+    bool timedOut = false;
+    double seconds = 0.0;
+    long maxRssKB = 0;              // peak resident set size of the tool itself
+    bool interrupted = false;       // killed because of interruptSignal()
+};
+
+// runTool with budgets. The tool runs in its own process group, so exceeding
+// the time limit kills it together with everything it started; the memory
+// limit is inherited by those processes. Since the group does not get the
+// signals of the terminal, the tool is killed the same way once an interrupt
+// handler (installInterruptHandler) has caught one.
+ToolUsage runToolLimited(const vector<string>& args, const string& outputFile, const ToolLimits& limits);
+
+// catches SIGINT and SIGTERM, for callers of runToolLimited that clean up and exit themselves
+void installInterruptHandler();
+// the signal caught by the handler, 0 if there was none
+int interruptSignal();
+
+// mkdir -p
+bool makeDirectories(const string& path);
+
+// replaces target by a hard link to source, or by a copy if the link fails
+// (e.g. across file systems); both via a temporary file and a rename, so a
+// concurrent reader of target never sees a partial file. Linked files must be
+// replaced and not written in place, the tools' output files are (see runTool).
+bool publishFile(const string& source, const string& target);
+
+// sizes and modification times of the named tools in toolDir, changes when one is rebuilt
+string toolStamp(const string& toolDir, const vector<string>& names);
+
+#endif /* SUBPROCESS_H_ */
@@ -0,0 +1,64 @@
+/**
+ * Small string helpers shared by the posterior tools
+ */
+
+#include <fstream>
+#include <sstream>
+#include "TextUtil.h"
+
+string trim(const string& str) {
+    size_t start = str.find_first_not_of(" \t\r\n");
+    size_t end = str.find_last_not_of(" \t\r\n");
+    
+    if (start == string::npos) return "";
+    return str.substr(start, end - start + 1);
+}
+
+vector<string> split(const string& str, char delimiter) {
+    vector<string> tokens;
+    stringstream ss(str);
+    string token;
+    
+    while (getline(ss, token, delimiter)) {
+        tokens.push_back(token);
+    }
+    
+    return tokens;
+}
+
+bool startsWith(const string& str, const string& prefix) {
+    if (str.length() < prefix.length()) return false;
+    return str.substr(0, prefix.length()) == prefix;
+}
+
+bool contains(const string& str, const string& substr) {
+    return str.find(substr) != string::npos;
+}
+
+uint64_t hashText(const string& text, uint64_t hash) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool readTextFile(const string& fileName, string& content) {
+    ifstream file(fileName);
+    if (!file.is_open()) {
+        return false;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+bool writeTextFile(const string& fileName, const string& content) {
+    ofstream file(fileName);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << content;
+    return file.good();
+}
@@ -0,0 +1,26 @@
+/**
+ * Small string helpers shared by the posterior tools
+ */
+
+#ifndef TEXTUTIL_H_
+#define TEXTUTIL_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+string trim(const string& str);
+vector<string> split(const string& str, char delimiter);
+bool startsWith(const string& str, const string& prefix);
+bool contains(const string& str, const string& substr);
+
+// FNV-1a, continued from hash; stable across runs and machines
+uint64_t hashText(const string& text, uint64_t hash = 14695981039346656037ULL);
+
+// read / write a whole text file, return false if the file cannot be opened
+bool readTextFile(const string& fileName, string& content);
+bool writeTextFile(const string& fileName, const string& content);
+
+#endif /* TEXTUTIL_H_ */
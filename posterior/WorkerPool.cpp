@@ -0,0 +1,64 @@
+/**
+ * Fixed number of worker threads executing submitted jobs, see WorkerPool.h
+ */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int numWorkers) {
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    wait();
+    {
+        unique_lock<mutex> guard(lock);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::submit(function<void()> job) {
+    if (workers.empty()) {
+        job();
+        return;
+    }
+    {
+        unique_lock<mutex> guard(lock);
+        jobs.push_back(move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+void WorkerPool::wait() {
+    unique_lock<mutex> guard(lock);
+    allDone.wait(guard, [this]() { return jobs.empty() && (running == 0); });
+}
+
+int WorkerPool::size() const {
+    return workers.size();
+}
+
+void WorkerPool::work() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        jobAvailable.wait(guard, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty()) {
+            return;
+        }
+        function<void()> job = move(jobs.front());
+        jobs.pop_front();
+        running++;
+        guard.unlock();
+        job();
+        guard.lock();
+        running--;
+        if (jobs.empty() && (running == 0)) {
+            allDone.notify_all();
+        }
+    }
+}
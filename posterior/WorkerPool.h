@@ -0,0 +1,44 @@
+/**
+ * Fixed number of worker threads executing submitted jobs in FIFO order
+ *
+ * A pool without workers runs every job directly inside submit(), so callers
+ * can use the same code path for sequential and parallel runs.
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+class WorkerPool {
+public:
+    WorkerPool(int numWorkers);
+    ~WorkerPool(); // waits for all submitted jobs
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(function<void()> job);
+    // blocks until all jobs submitted so far are done
+    void wait();
+    int size() const;
+
+private:
+    vector<thread> workers;
+    deque<function<void()>> jobs;
+    mutex lock;
+    condition_variable jobAvailable;
+    condition_variable allDone;
+    int running = 0;
+    bool stopping = false;
+
+    void work();
+};
+
+#endif /* WORKERPOOL_H_ */
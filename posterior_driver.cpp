@@ -0,0 +1,398 @@
+/**
+ * Posterior Estimation Driver
+ *
+ * Runs the iterative hypothesis selection of compute_posterior.sh /
+ * compute_monroe in a single process (see posterior/PosteriorDriver.h).
+ *
+ * Usage:
+ *   ./posterior_driver <domain_file> <problem_file> <observation_file> <num_obs> <k_iterations> <work_dir> [options]
+ *   ./posterior_driver sweep <domain_file> <problem_file> <observation_file> <k_iterations> <work_dir> [--from a] [--to b] [options]
+ *   ./posterior_driver batch <manifest> <results_dir> [batch options] [options]
+ *   ./posterior_driver merge <report_dir> <shard_results_dir>...
+ *   ./posterior_driver serve <domain_file> <problem_file> <observation_file> <k_iterations> <work_dir> [options]
+ *
+ * Output (in work_dir):
+ *   likelihoods.txt        hypothesis likelihood, in discovery order
+ *   posteriors.txt         hypothesis likelihood posterior, sorted by posterior
+ *   posterior_results.txt  configuration and both rankings
+ *
+ * A sweep runs the selection for every number of observations a..b (default:
+ * 0 to all) in work_dir/obs_<n> and writes work_dir/posterior_curve.txt.
+ *
+ * A batch runs every job of the manifest in results_dir/<name> (see
+ * posterior/BatchScheduler.h), the options are passed on to each job. With
+ * --shard i/n only the jobs of shard i are run; merge combines the results
+ * directories of the shards (run_sharded_batch.sh).
+ *
+ * serve starts from the observations in observation_file (may be empty) and
+ * reads further observations from stdin, one or more actions per line as in
+ * an observation file; "quit" or the end of the input stops it. After the
+ * first selection and after every line the posterior is written to stdout
+ * ("update <num_obs> searched|rescored <time> ms", one
+ * "hypothesis likelihood posterior" line per hypothesis, an empty line), the
+ * progress output of the driver goes to work_dir/serve.log.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include "posterior/PosteriorDriver.h"
+#include "posterior/BatchScheduler.h"
+#include "posterior/Subprocess.h"
+
+using namespace std;
+
+void printUsage(const char* progName) {
+    cout << "Usage: " << progName << " <domain_file> <problem_file> <observation_file> <num_obs> <k_iterations> <work_dir> [options]" << endl;
+    cout << "       " << progName << " sweep <domain_file> <problem_file> <observation_file> <k_iterations> <work_dir> [--from a] [--to b] [options]" << endl;
+    cout << "       " << progName << " batch <manifest> <results_dir> [batch options] [options]" << endl;
+    cout << "       " << progName << " merge <report_dir> <shard_results_dir>..." << endl;
+    cout << "       " << progName << " serve <domain_file> <problem_file> <observation_file> <k_iterations> <work_dir> [options]" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << "  --style tlt|hypotheses : domain style (default: detected from the domain)" << endl;
+    cout << "  --pgrpo                : partially observable PGR encoding (default: pgrfo)" << endl;
+    cout << "  --partial-obs          : partial observability in Stage III (default: full)" << endl;
+    cout << "  --p-det <p>            : detection probability for partial observability (default: 0.9)" << endl;
+    cout << "  --alpha <a>            : inverse temperature for Stage I (default: 1.0)" << endl;
+    cout << "  --tools <dir>          : directory containing the PANDA tools (default: .)" << endl;
+    cout << "  --clean                : remove the per-iteration files after the run" << endl;
+    cout << "  --no-planner-logs      : do not write the planner logs, they are read from the planner output directly" << endl;
+    cout << "  --reground             : remove hypotheses from the domain and ground again in every iteration" << endl;
+    cout << "  --workers <n>          : solve baselines and compute likelihoods on n threads (default: 1)" << endl;
+    cout << "  --solutions <n>        : take up to n hypotheses from one observation search (default: 1)" << endl;
+    cout << "  --planner-option <arg> : pass arg to pplanner for the observation search, e.g. to continue after a solution" << endl;
+    cout << "  --stop-epsilon <e>     : stop before k iterations once the remaining hypotheses move no posterior by e or more" << endl;
+    cout << "  --stop-top             : stop before k iterations once the remaining hypotheses cannot outrank the top-ranked one" << endl;
+    cout << "  --stop-bound <log_l>   : log likelihood bound of the remaining hypotheses, required by --stop-epsilon and --stop-top" << endl;
+    cout << "  --model-cache <dir>    : binary cache of the grounded models, can be shared by runs (default: <work_dir>/model_cache)" << endl;
+    cout << "  --no-model-cache       : always parse the grounded models" << endl;
+    cout << "  --baseline-cache <dir> : solved baseline problems, can be shared by runs (default: <work_dir>/baseline_cache)" << endl;
+    cout << "  --no-baseline-cache    : always ground and solve the baseline problems" << endl;
+    cout << "  --grounding-cache <dir>: grounded models by domain and problem, can be shared by runs (default: <work_dir>/grounding_cache)" << endl;
+    cout << "  --no-grounding-cache   : always parse and ground the problems" << endl;
+    cout << endl;
+    cout << "Batch options:" << endl;
+    cout << "  --jobs <n>             : number of jobs run at the same time (default: 1)" << endl;
+    cout << "  --time-limit <s>       : wall-clock limit per job in seconds (default: none)" << endl;
+    cout << "  --memory-limit <mb>    : address space limit per process of a job in MB (default: none)" << endl;
+    cout << "  --shard <i>/<n>        : run only shard i (0 <= i < n) of the jobs, split by problem and num_obs" << endl;
+    cout << "  --cache-dir <dir>      : model, baseline and grounding cache shared by the jobs, e.g. on a node-local disk" << endl;
+}
+
+int runBatch(int argc, char* argv[]) {
+    if (argc < 4) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    vector<BatchJob> jobs;
+    if (!readManifest(argv[2], jobs)) {
+        return 1;
+    }
+
+    BatchOptions options;
+    options.resultsDir = argv[3];
+    int shard = 0;
+    int numShards = 1;
+    char exe[4096];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len > 0) {
+        exe[len] = '\0';
+        options.driver = exe;
+    } else {
+        options.driver = argv[0];
+    }
+
+    for (int i = 4; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--jobs" && i + 1 < argc) {
+            options.workers = atoi(argv[++i]);
+        } else if (arg == "--time-limit" && i + 1 < argc) {
+            options.limits.timeLimit = atof(argv[++i]);
+        } else if (arg == "--memory-limit" && i + 1 < argc) {
+            options.limits.memoryLimitMB = atol(argv[++i]);
+        } else if (arg == "--shard" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d/%d", &shard, &numShards) != 2 || numShards < 1 || shard < 0 || shard >= numShards) {
+                cerr << "Error: Invalid shard (expected i/n with 0 <= i < n): " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            options.cacheDir = argv[++i];
+        } else {
+            options.driverArgs.push_back(arg);
+        }
+    }
+
+    if (numShards > 1) {
+        size_t numJobs = jobs.size();
+        jobs = shardJobs(jobs, shard, numShards);
+        cout << "Shard " << shard << "/" << numShards << ": " << jobs.size() << " of " << numJobs << " jobs" << endl;
+    }
+    BatchScheduler scheduler(jobs, options);
+    return scheduler.run() == 0 ? 0 : 1;
+}
+
+int runMerge(int argc, char* argv[]) {
+    if (argc < 4) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    vector<string> shardDirs(argv + 3, argv + argc);
+    return mergeShards(shardDirs, argv[2]) == 0 ? 0 : 1;
+}
+
+// parses the option at argv[i] (and its argument) into config
+bool parseOption(int argc, char* argv[], int& i, DriverConfig& config) {
+    string arg = argv[i];
+    if (arg == "--style" && i + 1 < argc) {
+        string style = argv[++i];
+        if (style == "tlt") {
+            config.style = TltWrapper;
+        } else if (style == "hypotheses") {
+            config.style = ExplicitHypotheses;
+        } else {
+            cerr << "Error: Unknown domain style: " << style << endl;
+            return false;
+        }
+    } else if (arg == "--pgrpo") {
+        config.encoding = PGRpo;
+    } else if (arg == "--partial-obs") {
+        config.likelihood.fullObservability = false;
+    } else if (arg == "--p-det" && i + 1 < argc) {
+        config.likelihood.pDet = atof(argv[++i]);
+    } else if (arg == "--alpha" && i + 1 < argc) {
+        config.likelihood.alpha = atof(argv[++i]);
+    } else if (arg == "--tools" && i + 1 < argc) {
+        config.toolDir = argv[++i];
+    } else if (arg == "--clean") {
+        config.keepFiles = false;
+    } else if (arg == "--no-planner-logs") {
+        config.plannerLogs = false;
+    } else if (arg == "--reground") {
+        config.groundOnce = false;
+    } else if (arg == "--workers" && i + 1 < argc) {
+        config.workers = atoi(argv[++i]);
+    } else if (arg == "--solutions" && i + 1 < argc) {
+        config.solutionsPerSearch = atoi(argv[++i]);
+    } else if (arg == "--stop-epsilon" && i + 1 < argc) {
+        config.stopEpsilon = atof(argv[++i]);
+    } else if (arg == "--stop-top") {
+        config.stopOnTop = true;
+    } else if (arg == "--stop-bound" && i + 1 < argc) {
+        config.stopLogBound = atof(argv[++i]);
+    } else if (arg == "--planner-option" && i + 1 < argc) {
+        config.plannerOptions.push_back(argv[++i]);
+    } else if (arg == "--model-cache" && i + 1 < argc) {
+        config.modelCacheDir = argv[++i];
+    } else if (arg == "--no-model-cache") {
+        config.modelCacheDir = "";
+    } else if (arg == "--baseline-cache" && i + 1 < argc) {
+        config.baselineCacheDir = argv[++i];
+    } else if (arg == "--no-baseline-cache") {
+        config.baselineCacheDir = "";
+    } else if (arg == "--grounding-cache" && i + 1 < argc) {
+        config.groundingCacheDir = argv[++i];
+    } else if (arg == "--no-grounding-cache") {
+        config.groundingCacheDir = "";
+    } else {
+        cerr << "Error: Unknown option: " << arg << endl;
+        return false;
+    }
+    return true;
+}
+
+void printConfiguration(ostream& out, const DriverConfig& config) {
+    out << "Configuration:" << endl;
+    out << "  Domain:       " << config.domainFile << endl;
+    out << "  Problem:      " << config.problemFile << endl;
+    out << "  Observations: " << config.observationFile << endl;
+    out << "  Num obs:      " << config.numObs << endl;
+    out << "  K iterations: " << config.kIterations << endl;
+    out << "  Work dir:     " << config.workDir << endl;
+    out << "  Workers:      " << config.workers << endl;
+    if ((config.stopEpsilon > 0.0) || config.stopOnTop) {
+        out << "  Early stop:   " << (config.stopOnTop ? "top-ranked fixed" : "")
+            << ((config.stopOnTop && (config.stopEpsilon > 0.0)) ? ", " : "");
+        if (config.stopEpsilon > 0.0) {
+            out << "posterior shift < " << config.stopEpsilon;
+        }
+        if (std::isfinite(config.stopLogBound)) {
+            out << " (log likelihood bound " << config.stopLogBound << ")" << endl;
+        } else {
+            out << " (off, needs --stop-bound)" << endl;
+        }
+    }
+    out << endl;
+}
+
+int runSweep(int argc, char* argv[]) {
+    if (argc < 7) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    DriverConfig config;
+    config.domainFile = argv[2];
+    config.problemFile = argv[3];
+    config.observationFile = argv[4];
+    config.kIterations = atoi(argv[5]);
+    config.workDir = argv[6];
+    config.modelCacheDir = config.workDir + "/model_cache";
+    config.baselineCacheDir = config.workDir + "/baseline_cache";
+    config.groundingCacheDir = config.workDir + "/grounding_cache";
+    config.style = detectDomainStyle(config.domainFile);
+    // the likelihood uses as many observations as were encoded
+    config.likelihood.numObservations = 0;
+
+    int firstObs = 0;
+    int lastObs = -1;
+    for (int i = 7; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            firstObs = atoi(argv[++i]);
+        } else if (arg == "--to" && i + 1 < argc) {
+            lastObs = atoi(argv[++i]);
+        } else if (!parseOption(argc, argv, i, config)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    cout << "============================================================" << endl;
+    cout << "Posterior Estimation over Observation Prefixes" << endl;
+    cout << "============================================================" << endl;
+    cout << endl;
+    printConfiguration(cout, config);
+
+    PosteriorDriver driver(config);
+    int status = driver.sweep(firstObs, lastObs);
+
+    string curveFile = config.workDir + "/posterior_curve.txt";
+    driver.writeCurve(curveFile);
+    cout << endl;
+    cout << "Results saved to: " << curveFile << endl;
+    return status;
+}
+
+int runServe(int argc, char* argv[]) {
+    if (argc < 7) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    DriverConfig config;
+    config.domainFile = argv[2];
+    config.problemFile = argv[3];
+    config.observationFile = argv[4];
+    config.kIterations = atoi(argv[5]);
+    config.workDir = argv[6];
+    config.modelCacheDir = config.workDir + "/model_cache";
+    config.baselineCacheDir = config.workDir + "/baseline_cache";
+    config.groundingCacheDir = config.workDir + "/grounding_cache";
+    config.style = detectDomainStyle(config.domainFile);
+
+    for (int i = 7; i < argc; i++) {
+        if (!parseOption(argc, argv, i, config)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // stdout only carries the updates
+    string logFile = config.workDir + "/serve.log";
+    ofstream log;
+    if (makeDirectories(config.workDir)) {
+        log.open(logFile);
+    }
+    if (!log.is_open()) {
+        cerr << "Error: Cannot write " << logFile << endl;
+        return 1;
+    }
+    ostream updates(cout.rdbuf());
+    cout.rdbuf(log.rdbuf());
+    printConfiguration(cout, config);
+
+    int status;
+    {
+        PosteriorDriver driver(config);
+        status = driver.serve(cin, updates);
+    }
+    cout.rdbuf(updates.rdbuf());
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "batch") {
+        return runBatch(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "merge") {
+        return runMerge(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "serve") {
+        return runServe(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "sweep") {
+        return runSweep(argc, argv);
+    }
+    if (argc < 7) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    DriverConfig config;
+    config.domainFile = argv[1];
+    config.problemFile = argv[2];
+    config.observationFile = argv[3];
+    config.numObs = atoi(argv[4]);
+    config.kIterations = atoi(argv[5]);
+    config.workDir = argv[6];
+    config.modelCacheDir = config.workDir + "/model_cache";
+    config.baselineCacheDir = config.workDir + "/baseline_cache";
+    config.groundingCacheDir = config.workDir + "/grounding_cache";
+    config.style = detectDomainStyle(config.domainFile);
+    config.likelihood.numObservations = config.numObs;
+
+    for (int i = 7; i < argc; i++) {
+        if (!parseOption(argc, argv, i, config)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    cout << "============================================================" << endl;
+    cout << "Posterior Estimation via Iterative Hypothesis Selection" << endl;
+    cout << "============================================================" << endl;
+    cout << endl;
+    printConfiguration(cout, config);
+
+    PosteriorDriver driver(config);
+    int status = driver.run();
+
+    string workDir = config.workDir + "/";
+    driver.writeLikelihoods(workDir + "likelihoods.txt");
+    driver.writePosteriors(workDir + "posteriors.txt");
+
+    string resultsFile = workDir + "posterior_results.txt";
+    ofstream results(resultsFile);
+    if (results.is_open()) {
+        results << "Posterior Estimation Results" << endl;
+        results << "============================" << endl;
+        results << endl;
+        results << "Configuration:" << endl;
+        results << "  Domain:       " << config.domainFile << endl;
+        results << "  Problem:      " << config.problemFile << endl;
+        results << "  Observations: " << config.numObs << endl;
+        results << "  K iterations: " << config.kIterations << endl;
+        results << endl;
+        results.close();
+        driver.writeSummary(resultsFile);
+    }
+
+    cout << endl;
+    cout << "Results saved to: " << resultsFile << endl;
+    return status;
+}
@@ -3,21 +3,19 @@
 //
 
 #include <fstream>
+#include <sstream>
 #include <map>
-#include <unordered_map>
 #include "GroundPrefixEncoding.h"
 #include <cassert>
 #include <algorithm>
 #include <list>
+#include <cstdio>
 
 
 void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingType enc, bool techVisible, int stopAfter) {
     //
     // read plan
     //
-    this->htn = htn;
-    this->encode = enc;
-
     vector<string> plan;
     bool fullsol = readSolution(sasPlan, plan, stopAfter); // returns whether the entire solution is parsed
     string filePostPix;
@@ -33,69 +31,105 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
         }
     }
 
-    unordered_map<string, int>* taskNameMapping = new unordered_map<string, int>;
-    set<int> technicalActions;
-    for (int i = 0; i < htn->numActions; i++) {
-#ifndef NDEBUG
-        if (taskNameMapping->find(htn->taskNames[i]) != taskNameMapping->end()) {
-            cout << "ERROR: Found two actions with same name" << endl;
-            exit(-1);
-        }
-#endif
-        taskNameMapping->insert({htn->taskNames[i], i});
+    string outFileName;
+    if (enc == Verification) {
+        outFileName = sasPlan.append(".prefixEncoding");
+    }  else if ((enc == PGRfo) || (enc == PGRpo)) {
+        outFileName = sasPlan.append(filePostPix + ".pgr");
+    }  else {
+        outFileName = sasPlan.append(".repair");
+    }
 
-        if ((!techVisible) && (htn->taskNames[i].rfind("__") == 0)) { // technical actions start with two underscores
-            technicalActions.insert(i);
-        }
+    std::ofstream fOut(outFileName);
+    encodingResult res = encodePlan(htn, plan, enc, techVisible, fOut);
+    fOut.close();
+    if (res == EncodingUnsolvable) {
+        remove(outFileName.c_str());
+        cout << "Verification problem proven UNSOLVABLE via reachability analysis." << endl;
+        exit(0);
+    } else if (res == EncodingFailed) {
+        exit(-1);
     }
+}
 
-    // generate set of distinct actions and sequence of plan steps
-    vector<int> prefix;
-    set<int> distPrefActions; // distinct actions in prefix
+encodingResult GroundPrefixEncoding::encodePlan(Model *htn, const vector<string> &plan, encodingType enc, bool techVisible, ostream &fOut) {
+    vector<int> planIds;
+    if (!mapPlan(htn, plan, planIds)) {
+        return EncodingFailed;
+    }
+    return encodePrefix(htn, planIds, enc, techVisible, fOut);
+}
+
+bool GroundPrefixEncoding::mapPlan(const Model *htn, const vector<string> &plan, vector<int> &planIds) const {
+    const NameIndex &names = htn->names();
+#ifndef NDEBUG
+    if (names.duplicateActionNames) {
+        cout << "ERROR: Found two actions with same name" << endl;
+        return false;
+    }
+#endif
+
+    planIds.clear();
+    planIds.reserve(plan.size());
     bool usinglowercase = false;
     string line;
     for (int i = 0; i < plan.size(); i++) {
         line = plan[i];
         if (usinglowercase) {
-            transform(line.begin(), line.end(), line.begin(), [](unsigned char c){ if (c == '-') return int('_'); return tolower(c); });
+            line = NameIndex::pddlCase(line);
+        }
+        if (line.rfind(';') == 0) { // skip comments
+            planIds.push_back(-1);
+            continue;
         }
-        if (line.rfind(';') == 0) continue; // skip comments
         line = line.substr(1, line.length() - 2);
-        if (line.rfind("epsilon") == 0) continue; // skip epsilon actions from TOAD
+        if (line.rfind("epsilon") == 0) { // skip epsilon actions from TOAD
+            planIds.push_back(-1);
+            continue;
+        }
 
-        auto iter = taskNameMapping->find(line);
-        if (iter == taskNameMapping->end()) {
+        int action = usinglowercase ? names.findActionPddlCase(line) : names.findAction(line);
+        if (action < 0) {
             // try with lower case
             cout << "- Did not find action \"" << line << "\", trying lower case." << endl;
-            taskNameMapping->clear();
-            for (int i = 0; i < htn->numActions; i++) { // todo: kill this
-                string name = htn->taskNames[i];
-                transform(name.begin(), name.end(), name.begin(), [](unsigned char c){ if (c == '-') return int('_'); return tolower(c); });
-                if (taskNameMapping->find(htn->taskNames[i]) != taskNameMapping->end()) {
-                    cout << "ERROR: Found two actions with same name" << endl;
-                    exit(-1);
-                }
-                taskNameMapping->insert({name, i});
-            }
-            transform(line.begin(), line.end(), line.begin(), [](unsigned char c){ if (c == '-') return int('_'); return tolower(c); });
-            iter = taskNameMapping->find(line);
-            if (iter != taskNameMapping->end()) {
+            line = NameIndex::pddlCase(line);
+            action = names.findActionPddlCase(line);
+            if (action >= 0) {
                 cout << "WARNING: Did not find mixed-case name of action, using lower case." << endl;
-                int i = iter->second;
-                prefix.push_back(i);
-                distPrefActions.insert(i);
+                planIds.push_back(action);
                 usinglowercase = true;
                 continue;
             }
             cout << "ERROR: task name not found: " << line << endl;
-            exit(-1);
+            return false;
         } else {
-            int i = iter->second;
-            prefix.push_back(i);
-            distPrefActions.insert(i);
+            planIds.push_back(action);
+        }
+    }
+    return true;
+}
+
+encodingResult GroundPrefixEncoding::encodePrefix(Model *htn, const vector<int> &planIds, encodingType enc, bool techVisible, ostream &fOut) {
+    this->htn = htn;
+    this->encode = enc;
+
+    set<int> technicalActions;
+    if (!techVisible) {
+        for (int i = 0; i < htn->numActions; i++) {
+            if (htn->taskNames[i].rfind("__") == 0) { // technical actions start with two underscores
+                technicalActions.insert(i);
+            }
         }
     }
-    delete taskNameMapping;
+
+    // generate set of distinct actions and sequence of plan steps
+    vector<int> prefix;
+    set<int> distPrefActions; // distinct actions in prefix
+    for (int i : planIds) {
+        if (i < 0) continue; // comment or epsilon action
+        prefix.push_back(i);
+        distPrefActions.insert(i);
+    }
 
     if (encode == Verification) {
         // for verification, we know very much about the state space and can do a special state-based pruning
@@ -106,22 +140,28 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
      * reachability analysis
      */
 
-    unordered_set<int> buReachableT;
-    unordered_set<int> buReachableM;
-    set<int> tdReachableT;
-    set<int> tdReachableM;
-
-    bool writeDummy = bottomUpReachability(technicalActions, distPrefActions, buReachableT, buReachableM);
-    if (buReachableT.find(htn->initialTask) == buReachableT.end()) {
-        cout << "Verification problem proven UNSOLVABLE via reachability analysis." << endl;
-        exit(0);
+    if (encode == Verification) {
+        // the prefix determines the reachable actions
+        vector<int> actions(distPrefActions.begin(), distPrefActions.end());
+        actions.insert(actions.end(), technicalActions.begin(), technicalActions.end());
+        reachability.compute(htn, actions);
+    } else {
+        // for both repair and PGR, all actions from the grounding are reachable, the analysis
+        // of the model is kept and only updated for the methods disabled in the meantime
+        // todo: this could be sharpened for some other cases (repair, sully obs. PGR, here you at least know the new start state)
+        reachability.update(htn);
+    }
+    const DenseSet &buReachableT = reachability.buReachableT;
+    const DenseSet &tdReachableT = reachability.tdReachableT;
+    const DenseSet &tdReachableM = reachability.tdReachableM;
+    bool writeDummy = reachability.writeDummy;
+    if (!buReachableT.contains(htn->initialTask)) {
+        return EncodingUnsolvable;
     }
 
-    topDownReachability(buReachableT, buReachableM, tdReachableT, tdReachableM);
     for (int action : distPrefActions) { // check whether prefix got unreachable
-        if (tdReachableT.find(action) == tdReachableT.end()) {
-            cout << "Verification problem proven UNSOLVABLE via reachability analysis." << endl;
-            exit(0);
+        if (!tdReachableT.contains(action)) {
+            return EncodingUnsolvable;
         }
     }
 
@@ -139,18 +179,18 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
 
     // determine which tasks need to be written
     // - the prefix (type "p" from above) is already created and its reachability is checked
-    set<int> typeTactions; // type "t" from above
-    set<int> absTasks; // type "c"
-    for (int t : tdReachableT) {
+    vector<int> typeTactions; // type "t" from above
+    vector<int> absTasks; // type "c"
+    tdReachableT.forEach([&](int t) {
         if (t < htn->numActions) {
             if ((encode != Verification) || (distPrefActions.find(t) == distPrefActions.end())) {
                 // for prefixEncoding, there do not need to be copies of the prefix actions, for repair and pgr, there must be
-                typeTactions.insert(t);
+                typeTactions.push_back(t);
             }
         } else  {
-            absTasks.insert(t);
+            absTasks.push_back(t);
         }
-    }
+    });
     map<int, int> old2new;
     map<int, int> distinctToTypeT;
     int current = prefix.size();
@@ -184,30 +224,20 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
     //
     // encode problem
     //
-    string outFileName;
-    if (encode == Verification) {
-        outFileName = sasPlan.append(".prefixEncoding");
-    }  else if ((encode == PGRfo) || (encode == PGRpo)) {
-        outFileName = sasPlan.append(filePostPix + ".pgr");
-    }  else {
-        outFileName = sasPlan.append(".repair");
-    }
-
-    std::ofstream fOut(outFileName);
-    fOut << ";; #state features" << endl;
-    fOut << (htn->numStateBits + numNewBits) << endl;
-    for (int i = 0; i < htn->numStateBits; i++) {
-        fOut << htn->factStrs[i] << endl;
+    if (cachedModel != htn) {
+        cacheModelSections(htn);
     }
+    PgrWriter w(fOut);
+    w << ";; #state features\n";
+    w << (htn->numStateBits + numNewBits) << '\n';
+    w << cachedFacts;
     for (int i = 0; i < numNewBits; i++) {
-        fOut << "prefpos" << i << endl;
+        w << "prefpos" << i << '\n';
     }
 
-    fOut << endl << ";; Mutex Groups" << endl;
-    fOut << (htn->numVars + 1) << endl;
-    for (int i = 0; i < htn->numVars; i++) {
-        fOut << htn->firstIndex[i] << " " << htn->lastIndex[i] << " " << htn->varNames[i] << endl;
-    }
+    w << "\n;; Mutex Groups\n";
+    w << (htn->numVars + 1) << '\n';
+    w << cachedVariables;
     int first;
     if (htn->numVars == 0) {
         first = 0;
@@ -215,35 +245,19 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
         first = htn->lastIndex[htn->numVars - 1] + 1;
     }
     int last = first + numNewBits - 1;
-    fOut << first << " " << last << " prefixOrdering" << endl;
-
-    fOut << endl << ";; further strict Mutex Groups" << endl;
-    fOut << htn->numStrictMutexes << endl;
-    for (int i = 0; i < htn->numStrictMutexes; i++) {
-        fOut << htn->strictMutexes[i][0] << " " << htn->strictMutexes[i][1] << " -1" << endl;
-    }
-
-    fOut << endl << ";; further non strict Mutex Groups" << endl;
-    fOut << htn->numMutexes << endl;
-    for (int i = 0; i < htn->numMutexes; i++) {
-        fOut << htn->mutexes[i][0] << " " << htn->mutexes[i][1] << " -1" << endl;
-    }
+    w << first << " " << last << " prefixOrdering" << '\n';
 
-    fOut << endl << ";; known invariants" << endl;
-    fOut << htn->numInvariants << endl;
-    for (int i = 0; i < htn->numInvariants; i++) {
-        fOut << htn->invariants[i][0] << " " << htn->invariants[i][1] << " -1" << endl;
-    }
+    w << cachedMutexes;
 
-    fOut << endl << ";; Actions" << endl;
+    w << '\n' << ";; Actions" << '\n';
     int numActions = prefix.size() + typeTactions.size();
     if (writeDummy) {
         numActions++;
     }
-    fOut << (numActions) << endl;
+    w << (numActions) << '\n';
     for (int i = 0; i < prefix.size(); i++) {
         // todo for repair: add the additional effects to the last action
-        writeAction(fOut, prefix[i], first + i, first + i + 1);
+        writeAction(w, prefix[i], first + i, first + i + 1);
     }
     for (int t : typeTactions) {
         int prec = -1;
@@ -255,24 +269,24 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
             }
         }
         // Note: PGRpo case deliberately omitted - no precondition added
-        writeAction(fOut, t, prec, -1);
+        writeAction(w, t, prec, -1);
     }
     if (writeDummy) {
-        fOut << "1\n-1\n-1\n-1\n";
+        w << "1\n-1\n-1\n-1\n";
     }
-    fOut << endl << ";; initial state" << endl;
+    w << '\n' << ";; initial state" << '\n';
     for (int i = 0; i < htn->s0Size; i++) {
-        fOut << htn->s0List[i] << " ";
+        w << htn->s0List[i] << " ";
     }
-    fOut << first << " -1" << endl;
+    w << first << " -1" << '\n';
 
-    fOut << endl << ";; goal" << endl;
+    w << '\n' << ";; goal" << '\n';
     for (int i = 0; i < htn->gSize; i++) {
-        fOut << htn->gList[i] << " ";
+        w << htn->gList[i] << " ";
     }
-    fOut << last - 1 << " -1" << endl;
+    w << last - 1 << " -1" << '\n';
 
-    fOut << endl << ";; tasks (primitive and abstract)" << endl;
+    w << '\n' << ";; tasks (primitive and abstract)" << '\n';
     int numTasks;
     if (encode == Verification) {
         numTasks = tdReachableT.size() + prefix.size();
@@ -291,177 +305,91 @@ void GroundPrefixEncoding::prefixEncoding(Model *htn, string sasPlan, encodingTy
              << " prefix.size()=" << prefix.size()
              << " writeDummy=" << writeDummy << endl;
         cout << "- debug: numTasks=" << numTasks << endl;
-        fOut << numTasks << endl;
+        w << numTasks << '\n';
 
     int check = 0;
     for (int i = 0; i < prefix.size(); i++) {
-        fOut << "0 " << htn->taskNames[prefix[i]] << endl;
+        w << "0 " << htn->taskNames[prefix[i]] << '\n';
         check++;
     }
     for (int t : typeTactions) {
-        fOut << "0 " << htn->taskNames[t] << endl;
+        w << "0 " << htn->taskNames[t] << '\n';
 		check++;
     }
     if (writeDummy) {
-        fOut << "0 EPSILONTASK[]" << endl;
+        w << "0 EPSILONTASK[]" << '\n';
         check++;
     }
     for (int i : absTasks) {
-        fOut << "1 " << htn->taskNames[i] << endl;
+        w << "1 " << htn->taskNames[i] << '\n';
         check++;
     }
     for (int t : distPrefActions) {
-        fOut << "1 <abs>" << htn->taskNames[t] << endl;
+        w << "1 <abs>" << htn->taskNames[t] << '\n';
         check++;
     }
     if (check != numTasks) {
         cout << "ERROR: check sums not correct." << endl;
         cout << "       number of actions " << check << " expected " << numTasks << endl;
         cout << "       creation of transformed problem failed." << endl;
-        exit(-1);
+        return EncodingFailed;
     }
 
-    fOut << endl << ";; initial abstract task" << endl;
-    fOut << old2new[htn->initialTask] << endl;
+    w << '\n' << ";; initial abstract task" << '\n';
+    w << old2new[htn->initialTask] << '\n';
 
-    fOut << endl << ";; methods" << endl;
+    w << '\n' << ";; methods" << '\n';
     int numMethods = tdReachableM.size() + prefix.size();
     // - for each task in the prefix, there will be an additional method
     if((encode == PGRfo) || (encode == PGRpo) || (encode == Repair)) {
         // - for pgr and repair, the actions are also allowed after the prefix, this adds another method per *distinct* action in prefix
         numMethods += distPrefActions.size();
     }
-    fOut << numMethods << endl;
+    w << numMethods << '\n';
 
     check = 0;
-    for (int i : tdReachableM) {
-        fOut << htn->methodNames[i] << endl;
-        fOut << old2new[htn->decomposedTask[i]] << endl;
+    tdReachableM.forEach([&](int i) {
+        w << htn->methodNames[i] << '\n';
+        w << old2new[htn->decomposedTask[i]] << '\n';
         if (htn->numSubTasks[i] == 0) {
-            fOut << dummyTaskID << " ";
+            w << dummyTaskID << " ";
         } else {
             for (int j = 0; j < htn->numSubTasks[i]; j++) {
-                fOut << old2new[htn->subTasks[i][j]] << " ";
+                w << old2new[htn->subTasks[i][j]] << " ";
             }
         }
-        fOut << "-1" << endl;
+        w << "-1" << '\n';
         for (int j = 0; j < htn->numOrderings[i]; j++) {
-            fOut << htn->ordering[i][j] << " ";
+            w << htn->ordering[i][j] << " ";
         }
-        fOut << "-1" << endl;
+        w << "-1" << '\n';
         check++;
-    }
+    });
 
     // methods from new abstract tasks to prefix copies
     for (int i = 0; i < prefix.size(); i++) {
         int a = prefix[i];
-        fOut << "_!<method2pref" << i << ">" << htn->taskNames[a] << endl;
-        fOut << prim2abs[a] << endl;
-        fOut << i << " -1" << endl;
-        fOut << "-1" << endl; // ordering relations
+        w << "_!<method2pref" << i << ">" << htn->taskNames[a] << '\n';
+        w << prim2abs[a] << '\n';
+        w << i << " -1" << '\n';
+        w << "-1" << '\n'; // ordering relations
         check++;
     }
 
     // methods from new abstract tasks to original actions
     if ((encode == PGRfo) || (encode == PGRpo) || (encode == Repair)) {
         for (int a: distPrefActions) {
-            fOut << "_!<method2org>" << htn->taskNames[a] << endl;
-            fOut << prim2abs[a] << endl; // this is the mapping from the action to the new abstract task
-            fOut << distinctToTypeT[a] << " -1"
-                 << endl; // this is the mapping to the original (non-prefix) copy of the action
-            fOut << "-1" << endl; // ordering relations
+            w << "_!<method2org>" << htn->taskNames[a] << '\n';
+            w << prim2abs[a] << '\n'; // this is the mapping from the action to the new abstract task
+            w << distinctToTypeT[a] << " -1"
+                 << '\n'; // this is the mapping to the original (non-prefix) copy of the action
+            w << "-1" << '\n'; // ordering relations
             check++;
         }
     }
     assert(check == numMethods);
 
-    fOut.close();
-}
-
-void GroundPrefixEncoding::topDownReachability(unordered_set<int> &buReachableT, unordered_set<int> &buReachableM,
-                                               set<int> &tdReachableT, set<int> &tdReachableM) {
-    cout << "- detecting top-down reachable tasks" << endl;
-    vector<int> fringe;
-    fringe.push_back(htn->initialTask);
-    tdReachableT.insert(htn->initialTask);
-    while (!fringe.empty()) {
-        int t = fringe.back();
-        fringe.pop_back();
-        if (buReachableT.find(t) == buReachableT.end())
-            continue;
-        for (int i = 0; i < htn->numMethodsForTask[t]; i++) {
-            int m = htn->taskToMethods[t][i];
-            if (buReachableM.find(m) == buReachableM.end())
-                continue;
-            tdReachableM.insert(m);
-            for (int j = 0; j < htn->numSubTasks[m]; j++) {
-                int subt = htn->subTasks[m][j];
-                if (tdReachableT.find(subt) == tdReachableT.end()) {
-                    tdReachableT.insert(subt);
-                    fringe.push_back(subt);
-                }
-            }
-        }
-    }
-}
-
-bool GroundPrefixEncoding::bottomUpReachability(set<int> &technicalActions, set<int> &distinctActions, unordered_set<int> &buReachableT, unordered_set<int> &buReachableM) {
-    cout << "- detecting unreachable tasks bottom-up" << endl;
-    int* methodST = new int[htn->numMethods];
-    for (int i = 0; i < htn->numMethods; i++) {
-        methodST[i] = htn->numDistinctSTs[i];
-    }
-
-    vector<int> fringe;
-    if (encode == Verification) {
-        // for repair, only actions from the solution sequence are reachable
-        fringe.reserve(distinctActions.size());
-        for (int action: distinctActions) {
-            fringe.push_back(action);
-        }
-        for (int action: technicalActions) {
-            fringe.push_back(action);
-        }
-    } else {
-        // for both repair and PGR, all actions from the grounding are reachable
-        // todo: this could be sharpened for some other cases (repair, sully obs. PGR, here you at least know the new start state)
-        fringe.reserve(htn->numActions);
-        for (int action = 0; action < htn->numActions; action++) {
-            fringe.push_back(action);
-        }
-    }
-
-    // handle empty methods
-    bool writeDummy= false;
-    for (int m = 0; m < htn->numMethods; m++) {
-        if (htn->numSubTasks[m] == 0) {
-            int t = htn->decomposedTask[m];
-            if (buReachableT.find(t) == buReachableT.end()) { // must be also done here, there could be more than one method deleting t ;-)
-                buReachableT.insert(t);
-                fringe.push_back(t);
-                buReachableM.insert(m);
-                writeDummy = true; // need to add a dummy task to empty methods
-            }
-        }
-    }
-
-    while (!fringe.empty()) {
-        int t = fringe.back();
-        fringe.pop_back();
-        for (int i = 0 ; i < htn->stToMethodNum[t]; i++) {
-            int m = htn->stToMethod[t][i];
-            if (--methodST[m] == 0) {
-                buReachableM.insert(m);
-                int t = htn->decomposedTask[m];
-                if (buReachableT.find(t) == buReachableT.end()) {
-                    buReachableT.insert(t);
-                    fringe.push_back(t);
-                }
-            }
-        }
-    }
-    delete[] methodST;
-    return writeDummy;
+    return EncodingWritten;
 }
 
 void GroundPrefixEncoding::doVerifyPruning(set<int> &technicalActions, vector<int> &prefix, set<int> &distinctActions) const {
@@ -550,6 +478,10 @@ void GroundPrefixEncoding::doVerifyPruning(set<int> &technicalActions, vector<in
 
 bool GroundPrefixEncoding::readSolution(const string &filename, vector<string> &plan_out, int stopafter) {
     ifstream fIn(filename);
+    return readSolution(fIn, plan_out, stopafter);
+}
+
+bool GroundPrefixEncoding::readSolution(istream &fIn, vector<string> &plan_out, int stopafter) {
     string line;
     int linesadded = 0;
     bool breakLoop = false;
@@ -589,7 +521,6 @@ bool GroundPrefixEncoding::readSolution(const string &filename, vector<string> &
     } else {
         cout << "Parsed solution up to action " << plan_out.size() << endl;
     }
-    fIn.close();
     return fileEnd;
 }
 
@@ -605,6 +536,56 @@ void GroundPrefixEncoding::cleanStr(string &action) const {
     }
 }
 
+void GroundPrefixEncoding::cacheModelSections(const Model *htn) {
+    ostringstream facts;
+    {
+        PgrWriter w(facts);
+        for (int i = 0; i < htn->numStateBits; i++) {
+            w << htn->factStrs[i] << '\n';
+        }
+    }
+    ostringstream variables;
+    {
+        PgrWriter w(variables);
+        for (int i = 0; i < htn->numVars; i++) {
+            w << htn->firstIndex[i] << ' ' << htn->lastIndex[i] << ' ' << htn->varNames[i] << '\n';
+        }
+    }
+    ostringstream mutexes;
+    {
+        PgrWriter w(mutexes);
+        w << "\n;; further strict Mutex Groups\n";
+        w << htn->numStrictMutexes << '\n';
+        for (int i = 0; i < htn->numStrictMutexes; i++) {
+            w << htn->strictMutexes[i][0] << ' ' << htn->strictMutexes[i][1] << " -1\n";
+        }
+
+        w << "\n;; further non strict Mutex Groups\n";
+        w << htn->numMutexes << '\n';
+        for (int i = 0; i < htn->numMutexes; i++) {
+            w << htn->mutexes[i][0] << ' ' << htn->mutexes[i][1] << " -1\n";
+        }
+
+        w << "\n;; known invariants\n";
+        w << htn->numInvariants << '\n';
+        for (int i = 0; i < htn->numInvariants; i++) {
+            w << htn->invariants[i][0] << ' ' << htn->invariants[i][1] << " -1\n";
+        }
+    }
+    cachedFacts = facts.str();
+    cachedVariables = variables.str();
+    cachedMutexes = mutexes.str();
+    cachedModel = htn;
+}
+
+void GroundPrefixEncoding::clearCache() {
+    cachedModel = nullptr;
+    reachability.clear();
+    cachedFacts.clear();
+    cachedVariables.clear();
+    cachedMutexes.clear();
+}
+
 bool GroundPrefixEncoding::isApplicable(const Model *htn, unordered_set<int> &state, int a) const {
     for (int j = 0; j < htn->numPrecs[a]; j++) {
         if (state.find(htn->precLists[a][j]) == state.end()) {
@@ -614,15 +595,15 @@ bool GroundPrefixEncoding::isApplicable(const Model *htn, unordered_set<int> &st
     return true;
 }
 
-void GroundPrefixEncoding::writeAction(ofstream &fOut, int iAction, int pFrom, int pTo) {
-    fOut << htn->actionCosts[iAction] << endl;
+void GroundPrefixEncoding::writeAction(PgrWriter &fOut, int iAction, int pFrom, int pTo) {
+    fOut << htn->actionCosts[iAction] << '\n';
     for (int j = 0; j < htn->numPrecs[iAction]; j++) {
         fOut << htn->precLists[iAction][j] << " ";
     }
     if (pFrom >= 0) {
         fOut << pFrom << " "; // add precondition
     }
-    fOut << "-1" << endl;
+    fOut << "-1" << '\n';
 
     for (int j = 0; j < htn->numAdds[iAction]; j++) {
         fOut << "0 " << htn->addLists[iAction][j] << "  ";
@@ -630,7 +611,7 @@ void GroundPrefixEncoding::writeAction(ofstream &fOut, int iAction, int pFrom, i
 	if (pTo >= 0){
     	fOut << "0 " << pTo << " "; // add add effect
 	}
-    fOut << "-1" << endl;
+    fOut << "-1" << '\n';
     if ((htn->numConditionalAdds[iAction] > 0) || (htn->numConditionalDels[iAction] > 0)) {
         cout << "Conditional effects not supported" << endl;
         exit(-1);
@@ -642,5 +623,5 @@ void GroundPrefixEncoding::writeAction(ofstream &fOut, int iAction, int pFrom, i
     if ((pFrom >= 0) && (pTo >= 0)) {
         fOut << "0 " << pFrom << " "; // add del effect
     }
-    fOut << "-1" << endl;
+    fOut << "-1" << '\n';
 }
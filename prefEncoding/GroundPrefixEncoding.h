@@ -7,19 +7,36 @@
 
 
 #include "../htnModel/Model.h"
+#include "PgrWriter.h"
+#include "TaskReachability.h"
 
 enum encodingType {Verification, PGRfo, PGRpo, Repair};
+enum encodingResult {EncodingWritten, EncodingUnsolvable, EncodingFailed};
 
 class GroundPrefixEncoding {
 
 public:
     void prefixEncoding(Model *htn, string sasPlan, encodingType enc, bool techVisible, int i);
 
-    void writeAction(ofstream &fOut, int iAction, int pFrom, int pTo);
+    // encodes an already parsed plan prefix (see readSolution) into fOut, does not terminate the process
+    encodingResult encodePlan(Model *htn, const vector<string> &plan, encodingType enc, bool techVisible, ostream &fOut);
+
+    // maps the plan steps to action ids, -1 for comments and epsilon actions; false if an action is unknown
+    bool mapPlan(const Model *htn, const vector<string> &plan, vector<int> &planIds) const;
+
+    // encodePlan for a plan already mapped by mapPlan, so prefixes of one plan can share the mapping
+    encodingResult encodePrefix(Model *htn, const vector<int> &planIds, encodingType enc, bool techVisible, ostream &fOut);
+
+    void writeAction(PgrWriter &fOut, int iAction, int pFrom, int pTo);
+
+    // the sections that only depend on the model (facts, mutex groups, invariants) and its
+    // reachability analysis are kept while the same model is encoded; call before the model is deleted
+    void clearCache();
 
     bool isApplicable(const Model *htn, unordered_set<int> &state, int a) const;
 
     bool readSolution(const string &filename, vector<string> &plan_out, int stopAfter);
+    bool readSolution(istream &in, vector<string> &plan_out, int stopAfter);
 
     encodingType encode = Verification;
 
@@ -28,11 +45,16 @@ public:
 
     void doVerifyPruning(set<int> &technicalActions, vector<int> &prefix, set<int> &distinctActions) const;
 
-    bool bottomUpReachability(set<int> &technicalActions, set<int> &distinctActions, unordered_set<int> &buReachableT, unordered_set<int> &buReachableM);
-
-    void topDownReachability(unordered_set<int> &buReachableT, unordered_set<int> &buReachableM, set<int> &tdReachableT, set<int> &tdReachableM);
+    TaskReachability reachability;
 
     void cleanStr(string &action) const;
+
+    const Model *cachedModel = nullptr;
+    string cachedFacts;
+    string cachedVariables;
+    string cachedMutexes;
+
+    void cacheModelSections(const Model *htn);
 };
 
 
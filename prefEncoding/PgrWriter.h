@@ -0,0 +1,96 @@
+//
+// Buffered writer for the encoded problems
+//
+
+#ifndef PGRWRITER_H
+#define PGRWRITER_H
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+// The output is collected in a large buffer and handed to the stream in one
+// write when the buffer is full (or the writer is flushed or destroyed).
+// Numbers are formatted directly into the buffer; unlike endl, '\n' does not
+// flush anything.
+class PgrWriter {
+public:
+    explicit PgrWriter(ostream &out, size_t capacity = 1 << 20) : out(out), capacity(capacity) {
+        buffer = new char[capacity];
+    }
+
+    ~PgrWriter() {
+        flush();
+        delete[] buffer;
+    }
+
+    PgrWriter(const PgrWriter &) = delete;
+    PgrWriter &operator=(const PgrWriter &) = delete;
+
+    PgrWriter &operator<<(int value) {
+        if (capacity - used < 12) {
+            flush();
+        }
+        char digits[12];
+        int n = 0;
+        unsigned int v = (value < 0) ? 0u - (unsigned int) value : (unsigned int) value;
+        do {
+            digits[n++] = (char) ('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        if (value < 0) {
+            buffer[used++] = '-';
+        }
+        while (n > 0) {
+            buffer[used++] = digits[--n];
+        }
+        return *this;
+    }
+
+    PgrWriter &operator<<(char c) {
+        if (used == capacity) {
+            flush();
+        }
+        buffer[used++] = c;
+        return *this;
+    }
+
+    PgrWriter &operator<<(const char *s) {
+        write(s, strlen(s));
+        return *this;
+    }
+
+    PgrWriter &operator<<(const string &s) {
+        write(s.data(), s.size());
+        return *this;
+    }
+
+    void write(const char *data, size_t size) {
+        if (size > capacity - used) {
+            flush();
+            if (size > capacity) { // e.g. a cached section, no need to copy it
+                out.write(data, size);
+                return;
+            }
+        }
+        memcpy(buffer + used, data, size);
+        used += size;
+    }
+
+    void flush() {
+        if (used > 0) {
+            out.write(buffer, used);
+            used = 0;
+        }
+    }
+
+private:
+    ostream &out;
+    char *buffer;
+    size_t capacity;
+    size_t used = 0;
+};
+
+#endif //PGRWRITER_H
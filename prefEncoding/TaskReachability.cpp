@@ -0,0 +1,267 @@
+//
+// Bottom-up and top-down reachability, see TaskReachability.h
+//
+
+#include <iostream>
+#include "TaskReachability.h"
+
+void TaskReachability::compute(const Model *htn, const vector<int> &actions) {
+    this->htn = htn;
+    allActions = false;
+    bottomUpReachability(actions);
+    topDownReachability();
+}
+
+void TaskReachability::update(const Model *htn) {
+    const vector<int> &log = htn->disabledMethodLog;
+    if ((this->htn == htn) && allActions && (numMaskResets == htn->numMaskResets) && (numLogged <= log.size())) {
+        if (numLogged < log.size()) {
+            disableMethods(numLogged);
+            numLogged = log.size();
+        }
+        return;
+    }
+
+    this->htn = htn;
+    vector<int> actions(htn->numActions);
+    for (int a = 0; a < htn->numActions; a++) {
+        actions[a] = a;
+    }
+    bottomUpReachability(actions);
+    topDownReachability();
+    allActions = true;
+    numMaskResets = htn->numMaskResets;
+    numLogged = log.size();
+}
+
+void TaskReachability::clear() {
+    htn = nullptr;
+    allActions = false;
+    unreachableSTs.clear();
+    emptyMethod.clear();
+}
+
+void TaskReachability::bottomUpReachability(const vector<int> &actions) {
+    cout << "- detecting unreachable tasks bottom-up" << endl;
+    buReachableT.reset(htn->numTasks);
+    buReachableM.reset(htn->numMethods);
+    unreachableSTs.assign(htn->numDistinctSTs, htn->numDistinctSTs + htn->numMethods);
+    emptyMethod.assign(htn->numTasks, -1);
+    numEmptyMethods = 0;
+
+    vector<int> fringe(actions);
+
+    // handle empty methods
+    for (int m = 0; m < htn->numMethods; m++) {
+        if ((htn->numSubTasks[m] == 0) && htn->isMethodEnabled(m)) {
+            numEmptyMethods++; // need to add a dummy task to empty methods
+            int t = htn->decomposedTask[m];
+            if (buReachableT.insert(t)) { // there could be more than one method deleting t
+                fringe.push_back(t);
+                buReachableM.insert(m);
+                emptyMethod[t] = m;
+            }
+        }
+    }
+    writeDummy = (numEmptyMethods > 0);
+
+    while (!fringe.empty()) {
+        int t = fringe.back();
+        fringe.pop_back();
+        for (int i = 0; i < htn->stToMethodNum[t]; i++) {
+            int m = htn->stToMethod[t][i];
+            if (--unreachableSTs[m] == 0) {
+                buReachableM.insert(m);
+                int t2 = htn->decomposedTask[m];
+                if (buReachableT.insert(t2)) {
+                    fringe.push_back(t2);
+                }
+            }
+        }
+    }
+}
+
+void TaskReachability::topDownReachability() {
+    tdReachableT.reset(htn->numTasks);
+    tdReachableM.reset(htn->numMethods);
+    if (!buReachableT.contains(htn->initialTask)) {
+        return;
+    }
+
+    cout << "- detecting top-down reachable tasks" << endl;
+    vector<int> fringe;
+    fringe.push_back(htn->initialTask);
+    tdReachableT.insert(htn->initialTask);
+    while (!fringe.empty()) {
+        int t = fringe.back();
+        fringe.pop_back();
+        if (!buReachableT.contains(t))
+            continue;
+        for (int i = 0; i < htn->numMethodsForTask[t]; i++) {
+            int m = htn->taskToMethods[t][i];
+            if (!buReachableM.contains(m))
+                continue;
+            tdReachableM.insert(m);
+            for (int j = 0; j < htn->numSubTasks[m]; j++) {
+                int subt = htn->subTasks[m][j];
+                if (tdReachableT.insert(subt)) {
+                    fringe.push_back(subt);
+                }
+            }
+        }
+    }
+}
+
+// the methods log[from..] have been disabled since the last analysis
+void TaskReachability::disableMethods(size_t from) {
+    const vector<int> &log = htn->disabledMethodLog;
+    cout << "- updating reachability for " << (log.size() - from) << " disabled method(s)" << endl;
+
+    vector<int> removedM;
+    vector<int> addedM; // empty methods that take over from a disabled one
+    vector<int> suspects;
+    for (size_t k = from; k < log.size(); k++) {
+        int m = log[k];
+        int t = htn->decomposedTask[m];
+        if (htn->numSubTasks[m] == 0) {
+            numEmptyMethods--;
+            if (emptyMethod[t] != m)
+                continue;
+            // with a full analysis, the first enabled empty method of t would be taken
+            buReachableM.erase(m);
+            removedM.push_back(m);
+            emptyMethod[t] = -1;
+            for (int i = 0; i < htn->numMethodsForTask[t]; i++) {
+                int m2 = htn->taskToMethods[t][i];
+                if ((htn->numSubTasks[m2] == 0) && ((emptyMethod[t] < 0) || (m2 < emptyMethod[t])))
+                    emptyMethod[t] = m2;
+            }
+            if (emptyMethod[t] >= 0) {
+                buReachableM.insert(emptyMethod[t]);
+                addedM.push_back(emptyMethod[t]);
+            } else {
+                suspects.push_back(t);
+            }
+        } else if (buReachableM.erase(m)) {
+            removedM.push_back(m);
+            suspects.push_back(t);
+        }
+    }
+    writeDummy = (numEmptyMethods > 0);
+
+    // delete everything that may depend on the removed methods
+    vector<int> deletedT;
+    while (!suspects.empty()) {
+        int t = suspects.back();
+        suspects.pop_back();
+        if ((emptyMethod[t] >= 0) || !buReachableT.erase(t))
+            continue;
+        deletedT.push_back(t);
+        for (int i = 0; i < htn->stToMethodNum[t]; i++) {
+            int m = htn->stToMethod[t][i];
+            unreachableSTs[m]++;
+            if (buReachableM.erase(m)) {
+                removedM.push_back(m);
+                suspects.push_back(htn->decomposedTask[m]);
+            }
+        }
+    }
+
+    // and derive again what is still reachable via other methods
+    vector<int> fringe;
+    for (int t : deletedT) {
+        for (int i = 0; i < htn->numMethodsForTask[t]; i++) {
+            int m = htn->taskToMethods[t][i];
+            if ((htn->numSubTasks[m] > 0) && (unreachableSTs[m] == 0)) {
+                buReachableT.insert(t);
+                fringe.push_back(t);
+                break;
+            }
+        }
+    }
+    while (!fringe.empty()) {
+        int t = fringe.back();
+        fringe.pop_back();
+        for (int i = 0; i < htn->stToMethodNum[t]; i++) {
+            int m = htn->stToMethod[t][i];
+            if (--unreachableSTs[m] == 0) {
+                buReachableM.insert(m);
+                int t2 = htn->decomposedTask[m];
+                if (buReachableT.insert(t2)) {
+                    fringe.push_back(t2);
+                }
+            }
+        }
+    }
+
+    vector<int> lostM;
+    for (int m : removedM) {
+        if (!buReachableM.contains(m))
+            lostM.push_back(m);
+    }
+    removeTopDown(lostM);
+
+    for (int m : addedM) {
+        int t = htn->decomposedTask[m];
+        if (buReachableT.contains(t) && tdReachableT.contains(t))
+            tdReachableM.insert(m);
+    }
+}
+
+// top-down part of disableMethods(): same scheme, for methods that are no longer bottom-up reachable
+void TaskReachability::removeTopDown(const vector<int> &removedM) {
+    if (!buReachableT.contains(htn->initialTask)) {
+        tdReachableT.reset(htn->numTasks);
+        tdReachableM.reset(htn->numMethods);
+        return;
+    }
+
+    vector<int> suspects;
+    for (int m : removedM) {
+        if (tdReachableM.erase(m)) {
+            suspects.insert(suspects.end(), htn->subTasks[m], htn->subTasks[m] + htn->numSubTasks[m]);
+        }
+    }
+    vector<int> deletedT;
+    while (!suspects.empty()) {
+        int t = suspects.back();
+        suspects.pop_back();
+        if ((t == htn->initialTask) || !tdReachableT.erase(t))
+            continue;
+        deletedT.push_back(t);
+        for (int i = 0; i < htn->numMethodsForTask[t]; i++) {
+            int m = htn->taskToMethods[t][i];
+            if (tdReachableM.erase(m)) {
+                suspects.insert(suspects.end(), htn->subTasks[m], htn->subTasks[m] + htn->numSubTasks[m]);
+            }
+        }
+    }
+
+    vector<int> fringe;
+    for (int t : deletedT) {
+        for (int i = 0; i < htn->stToMethodNum[t]; i++) {
+            if (tdReachableM.contains(htn->stToMethod[t][i])) {
+                tdReachableT.insert(t);
+                fringe.push_back(t);
+                break;
+            }
+        }
+    }
+    while (!fringe.empty()) {
+        int t = fringe.back();
+        fringe.pop_back();
+        if (!buReachableT.contains(t))
+            continue;
+        for (int i = 0; i < htn->numMethodsForTask[t]; i++) {
+            int m = htn->taskToMethods[t][i];
+            if (!buReachableM.contains(m) || !tdReachableM.insert(m))
+                continue;
+            for (int j = 0; j < htn->numSubTasks[m]; j++) {
+                int subt = htn->subTasks[m][j];
+                if (tdReachableT.insert(subt)) {
+                    fringe.push_back(subt);
+                }
+            }
+        }
+    }
+}
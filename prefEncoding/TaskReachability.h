@@ -0,0 +1,103 @@
+//
+// Bottom-up and top-down reachability of the tasks and methods of a model
+//
+// For PGR and repair, all actions are reachable and the result only depends on
+// the model and its method mask. update() keeps the result of the last call and,
+// if only methods have been disabled since (Model::disabledMethodLog), removes
+// what depended on them instead of computing both fixpoints again: everything
+// that may have been derived via a disabled method is deleted first and the
+// parts that have another derivation are derived again (the models are
+// recursive, so simply counting the supports is not enough).
+//
+
+#ifndef TASKREACHABILITY_H
+#define TASKREACHABILITY_H
+
+#include <cstdint>
+#include <vector>
+#include "../htnModel/Model.h"
+
+using namespace std;
+using namespace progression;
+
+// set of the ids 0..n-1, iterated in ascending order
+class DenseSet {
+public:
+    void reset(int n) {
+        words.assign((n + 63) / 64, 0);
+        num = 0;
+    }
+
+    bool contains(int i) const {
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+
+    bool insert(int i) { // false if i was contained already
+        uint64_t bit = uint64_t(1) << (i & 63);
+        if (words[i >> 6] & bit) return false;
+        words[i >> 6] |= bit;
+        num++;
+        return true;
+    }
+
+    bool erase(int i) { // false if i was not contained
+        uint64_t bit = uint64_t(1) << (i & 63);
+        if (!(words[i >> 6] & bit)) return false;
+        words[i >> 6] &= ~bit;
+        num--;
+        return true;
+    }
+
+    int size() const {
+        return num;
+    }
+
+    template<class F>
+    void forEach(F f) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            uint64_t bits = words[w];
+            while (bits) {
+                f(int(w * 64 + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    vector<uint64_t> words;
+    int num = 0;
+};
+
+class TaskReachability {
+public:
+    DenseSet buReachableT; // abstract tasks, the actions are not contained
+    DenseSet buReachableM;
+    DenseSet tdReachableT; // only valid if the initial task is bottom-up reachable
+    DenseSet tdReachableM;
+    bool writeDummy = false; // there are (enabled) empty methods
+
+    // complete analysis, bottom-up from the given actions
+    void compute(const Model *htn, const vector<int> &actions);
+
+    // analysis with all actions reachable, updated from the last call if possible
+    void update(const Model *htn);
+
+    void clear();
+
+private:
+    const Model *htn = nullptr;
+    bool allActions = false; // the last analysis is one of update()
+    int numMaskResets = 0;
+    size_t numLogged = 0; // entries of the disabled method log already included
+
+    vector<int> unreachableSTs; // per method, distinct subtasks not reachable bottom-up
+    vector<int> emptyMethod;    // per task, its (first enabled) empty method that makes it reachable, or -1
+    int numEmptyMethods = 0;    // enabled empty methods
+
+    void bottomUpReachability(const vector<int> &actions);
+    void topDownReachability();
+    void disableMethods(size_t from);
+    void removeTopDown(const vector<int> &removedM);
+};
+
+#endif //TASKREACHABILITY_H
@@ -0,0 +1,131 @@
+//
+// Incremental TaskReachability::update() against a complete analysis, on
+// random recursive models with empty methods whose methods are disabled a few
+// at a time (and enabled again now and then). Returns nonzero on a difference.
+//
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "TaskReachability.h"
+
+static int* newRow(const vector<int> &v) {
+    int *row = new int[max((int) v.size(), 1)];
+    copy(v.begin(), v.end(), row);
+    return row;
+}
+
+// the method structures TaskReachability reads, with ascending rows as read()
+// builds them. Actions are 0..numActions-1, the other tasks are abstract. The
+// model is not deleted since ~Model() expects the rest of what read() sets up.
+static Model *randomModel(mt19937 &rng, int numActions, int numAbstract, int numMethods) {
+    Model *htn = new Model();
+    htn->isHtnModel = true;
+    htn->numActions = numActions;
+    htn->numTasks = numActions + numAbstract;
+    htn->numMethods = numMethods;
+    htn->initialTask = numActions + uniform_int_distribution<int>(0, numAbstract - 1)(rng);
+    htn->decomposedTask = new int[numMethods];
+    htn->numSubTasks = new int[numMethods];
+    htn->subTasks = new int *[numMethods];
+    htn->numDistinctSTs = new int[numMethods];
+    htn->sortedDistinctSubtasks = new int *[numMethods];
+
+    vector<vector<int>> taskToMethods(htn->numTasks);
+    vector<vector<int>> stToMethod(htn->numTasks);
+    for (int m = 0; m < numMethods; m++) {
+        int t = numActions + uniform_int_distribution<int>(0, numAbstract - 1)(rng);
+        // about one in six methods is empty
+        int n = uniform_int_distribution<int>(0, 5)(rng) == 0 ? 0 : uniform_int_distribution<int>(1, 4)(rng);
+        vector<int> subtasks(n);
+        for (int &st : subtasks) {
+            st = uniform_int_distribution<int>(0, htn->numTasks - 1)(rng);
+        }
+        set<int> distinct(subtasks.begin(), subtasks.end());
+
+        htn->decomposedTask[m] = t;
+        htn->numSubTasks[m] = n;
+        htn->subTasks[m] = newRow(subtasks);
+        htn->numDistinctSTs[m] = distinct.size();
+        htn->sortedDistinctSubtasks[m] = newRow(vector<int>(distinct.begin(), distinct.end()));
+        taskToMethods[t].push_back(m);
+        for (int st : distinct) {
+            stToMethod[st].push_back(m);
+        }
+    }
+
+    htn->numMethodsForTask = new int[htn->numTasks];
+    htn->taskToMethods = new int *[htn->numTasks];
+    htn->stToMethodNum = new int[htn->numTasks];
+    htn->stToMethod = new int *[htn->numTasks];
+    for (int t = 0; t < htn->numTasks; t++) {
+        htn->numMethodsForTask[t] = taskToMethods[t].size();
+        htn->taskToMethods[t] = newRow(taskToMethods[t]);
+        htn->stToMethodNum[t] = stToMethod[t].size();
+        htn->stToMethod[t] = newRow(stToMethod[t]);
+    }
+    return htn;
+}
+
+static vector<int> members(const DenseSet &s) {
+    vector<int> v;
+    s.forEach([&v](int i) { v.push_back(i); });
+    return v;
+}
+
+static bool sameResult(const TaskReachability &a, const TaskReachability &b) {
+    return (members(a.buReachableT) == members(b.buReachableT))
+           && (members(a.buReachableM) == members(b.buReachableM))
+           && (members(a.tdReachableT) == members(b.tdReachableT))
+           && (members(a.tdReachableM) == members(b.tdReachableM))
+           && (a.writeDummy == b.writeDummy);
+}
+
+int main() {
+    // the analysis reports its steps on cout
+    stringstream progress;
+    streambuf *console = cout.rdbuf(progress.rdbuf());
+
+    mt19937 rng(20240614);
+    int failures = 0;
+    int cases = 0;
+
+    for (int run = 0; run < 300; run++) {
+        // more than 64 tasks and methods in some runs, so the sets span several words
+        bool large = (run % 4 == 0);
+        int numActions = uniform_int_distribution<int>(1, large ? 40 : 6)(rng);
+        int numAbstract = uniform_int_distribution<int>(1, large ? 80 : 8)(rng);
+        int numMethods = uniform_int_distribution<int>(1, large ? 200 : 20)(rng);
+        Model *htn = randomModel(rng, numActions, numAbstract, numMethods);
+
+        TaskReachability incremental;
+        incremental.update(htn);
+        for (int round = 0; round < 12; round++) {
+            if (uniform_int_distribution<int>(0, 5)(rng) == 0) {
+                htn->enableAllMethods();
+            } else {
+                int num = uniform_int_distribution<int>(1, 3)(rng);
+                for (int i = 0; i < num; i++) {
+                    htn->disableMethod(uniform_int_distribution<int>(0, numMethods - 1)(rng));
+                }
+            }
+            incremental.update(htn);
+
+            TaskReachability complete;
+            complete.update(htn);
+            cases++;
+            if (!sameResult(incremental, complete)) {
+                failures++;
+                cerr << "run " << run << " round " << round << ": the update differs from a complete analysis ("
+                     << incremental.buReachableM.size() << "/" << complete.buReachableM.size() << " bottom-up, "
+                     << incremental.tdReachableM.size() << "/" << complete.tdReachableM.size()
+                     << " top-down reachable methods)" << endl;
+            }
+        }
+    }
+
+    cout.rdbuf(console);
+    cout << "Task reachability: " << (cases - failures) << "/" << cases << " cases agree" << endl;
+    return failures == 0 ? 0 : 1;
+}
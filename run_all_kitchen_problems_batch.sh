@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Same sweep as run_all_kitchen_problems_full.sh, scheduled by posterior_driver batch:
+# one global queue over all problems and observation counts instead of MAX_JOBS per problem.
+# Jobs listed as ok in results_batch/batch_checkpoint.txt are skipped, so an interrupted sweep can be resumed;
+# failed and timed out jobs run again.
+
+JOBS=${JOBS:-$(nproc)}
+TIME_LIMIT=${TIME_LIMIT:-3600}
+MEMORY_LIMIT=${MEMORY_LIMIT:-8192}
+
+mkdir -p results_batch
+MANIFEST="results_batch/manifest.txt"
+
+echo "# domain problem observations num_obs k name" > "$MANIFEST"
+for PROBLEM_FILE in benchmarks/kitchen-100/01-problems/p-*.hddl; do
+    BASE_NAME=$(basename "$PROBLEM_FILE" .hddl)
+    OBSERVATION_FILE="benchmarks/kitchen-100/02-solutions/$BASE_NAME.txt"
+    NUM_ACTIONS=$(grep -o "([^()]*)" "$OBSERVATION_FILE" | wc -l | tr -d ' ')
+
+    for OBS_COUNT in $(seq 0 $NUM_ACTIONS); do
+        echo "benchmarks/kitchen-100/00-domain/domain_explicit_hypotheses.hddl $PROBLEM_FILE $OBSERVATION_FILE $OBS_COUNT 5 $BASE_NAME/obs_$OBS_COUNT" >> "$MANIFEST"
+    done
+done
+
+./posterior_driver batch "$MANIFEST" results_batch --jobs $JOBS --time-limit $TIME_LIMIT --memory-limit $MEMORY_LIMIT
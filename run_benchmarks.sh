@@ -0,0 +1,70 @@
+#!/bin/bash
+
+# Reproducible benchmark over a fixed subset of the kitchen and Monroe problems.
+# Every case (problem x full/partial observations) is run REPEAT times with all observations through
+# posterior_driver batch, one job at a time and without the model, baseline and grounding caches, so that every run
+# grounds and solves everything again. Writes to $OUT:
+#   e2e.json           median / p95 wall time and peak RSS of the driver per case (benchmark_pipeline summary)
+#   stages/<case>.json median / p95 per pipeline stage on the observation problem of the first run
+#                      (benchmark_pipeline stages on 1_grounded.psas and 1_obs_pgr.log of the job)
+
+BENCH=${BENCH:-benchmark}
+OUT=${OUT:-results_benchmark}
+REPEAT=${REPEAT:-5}
+STAGE_REPEAT=${STAGE_REPEAT:-20}
+K_ITERATIONS=${K_ITERATIONS:-5}
+TIME_LIMIT=${TIME_LIMIT:-3600}
+MEMORY_LIMIT=${MEMORY_LIMIT:-8192}
+DRIVER=${DRIVER:-./posterior_driver}
+PIPELINE=${PIPELINE:-./benchmark_pipeline}
+
+KITCHEN_PROBLEMS="p-0003-kitchen p-0012-kitchen p-0032-kitchen p-0044-kitchen p-0059-kitchen"
+MONROE_PROBLEMS="p-0001-clear-road-wreck p-0002-plow-road p-0004-provide-medical-attention p-0014-fix-power-line p-0020-set-up-shelter"
+
+rm -rf "$OUT"
+mkdir -p "$OUT/stages"
+
+# <manifest> <domain> <problem> <observations> <case>
+add_case() {
+    NUM_ACTIONS=$(grep -o "([^()]*)" "$4" | wc -l | tr -d ' ')
+    for RUN in $(seq 1 $REPEAT); do
+        echo "$2 $3 $4 $NUM_ACTIONS $K_ITERATIONS $5/run_$RUN" >> "$1"
+    done
+}
+
+echo "# domain problem observations num_obs k name" > "$OUT/manifest_full.txt"
+echo "# domain problem observations num_obs k name" > "$OUT/manifest_partial.txt"
+for PROBLEM in $KITCHEN_PROBLEMS; do
+    add_case "$OUT/manifest_full.txt" "$BENCH/kitchen-100/00-domain/domain_explicit_hypotheses.hddl" \
+        "$BENCH/kitchen-100/01-problems/$PROBLEM.hddl" "$BENCH/kitchen-100/02-solutions/$PROBLEM.txt" "kitchen_full/$PROBLEM"
+    add_case "$OUT/manifest_partial.txt" "$BENCH/kitchen-100/00-domain/domain_explicit_hypotheses.hddl" \
+        "$BENCH/kitchen-100/01-problems/$PROBLEM.hddl" "$BENCH/kitchen-100/03-partial-solutions/$PROBLEM.txt" "kitchen_partial/$PROBLEM"
+done
+for PROBLEM in $MONROE_PROBLEMS; do
+    PROBLEM_ID=$(echo "$PROBLEM" | cut -d'-' -f2)
+    add_case "$OUT/manifest_full.txt" "$BENCH/monroe-100/00-domain/domain.hddl" \
+        "$BENCH/monroe-100/01-problems/$PROBLEM.hddl" "$BENCH/monroe-100/02-solutions/solution-$PROBLEM_ID.txt" "monroe_full/$PROBLEM"
+done
+
+OPTIONS="--jobs 1 --time-limit $TIME_LIMIT --memory-limit $MEMORY_LIMIT --no-model-cache --no-baseline-cache --no-grounding-cache"
+"$DRIVER" batch "$OUT/manifest_full.txt" "$OUT" $OPTIONS
+# the partial observations are not contiguous, encode them like compute_posterior_partial.sh
+"$DRIVER" batch "$OUT/manifest_partial.txt" "$OUT" $OPTIONS --pgrpo --partial-obs
+
+"$PIPELINE" summary "$OUT/batch_checkpoint.txt" --json "$OUT/e2e.json"
+
+while read -r DOMAIN PROBLEM OBSERVATIONS NUM_OBS K NAME; do
+    case "$DOMAIN" in "#"*) continue ;; esac
+    [ "${NAME##*/}" = "run_1" ] || continue
+    CASE=${NAME%/run_1}
+    STAGE_OPTIONS="--repeat $STAGE_REPEAT"
+    case "$CASE" in *_partial/*) STAGE_OPTIONS="$STAGE_OPTIONS --partial-obs" ;; esac
+    if [ -f "$OUT/$NAME/1_grounded.psas" ] && [ -f "$OUT/$NAME/1_obs_pgr.log" ]; then
+        "$PIPELINE" stages "$OUT/$NAME/1_grounded.psas" "$OBSERVATIONS" "$OUT/$NAME/1_obs_pgr.log" \
+            $STAGE_OPTIONS --json "$OUT/stages/${CASE//\//_}.json" > /dev/null
+    else
+        echo "Skipping stages of $CASE: no grounded model or planner log in $OUT/$NAME"
+    fi
+done < <(cat "$OUT/manifest_full.txt" "$OUT/manifest_partial.txt")
+
+echo "Results in $OUT/e2e.json and $OUT/stages/"
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# Runs a batch manifest (see run_all_kitchen_problems_batch.sh) split into shards over several machines and merges
+# the results. Usage:
+#   HOSTS="node1 node2 node3" ./run_sharded_batch.sh <manifest> <results_dir> [driver options]
+# Shard i of n (n = number of HOSTS) runs on the i-th host over ssh, in the current directory, which has to be the
+# same path on every host (shared file system). The shards write to <results_dir>/shard_<i> and share a node-local
+# model, baseline and grounding cache in $CACHE_DIR. Without HOSTS the SHARDS shards run one after the other on this machine.
+# An interrupted shard is resumed by running the script again; the report is written to <results_dir>/merged.
+#
+# Without ssh, run "posterior_driver batch <manifest> <results_dir>/shard_<i> --shard <i>/<n>" on every node in any
+# way and then "posterior_driver merge <results_dir>/merged <results_dir>/shard_*".
+
+if [ $# -lt 2 ]; then
+    echo "Usage: HOSTS=\"node1 node2\" $0 <manifest> <results_dir> [driver options]"
+    exit 1
+fi
+MANIFEST=$1
+RESULTS=$2
+shift 2
+
+JOBS=${JOBS:-$(nproc)}
+TIME_LIMIT=${TIME_LIMIT:-3600}
+MEMORY_LIMIT=${MEMORY_LIMIT:-8192}
+CACHE_DIR=${CACHE_DIR:-/tmp/posterior_cache}
+HOSTS=${HOSTS:-}
+SHARDS=${SHARDS:-1}
+
+mkdir -p "$RESULTS"
+OPTIONS="--jobs $JOBS --time-limit $TIME_LIMIT --memory-limit $MEMORY_LIMIT --cache-dir $CACHE_DIR $*"
+
+if [ -n "$HOSTS" ]; then
+    set -- $HOSTS
+    NUM_SHARDS=$#
+    SHARD=0
+    for HOST in $HOSTS; do
+        echo "Shard $SHARD/$NUM_SHARDS on $HOST"
+        ssh "$HOST" "cd '$PWD' && ./posterior_driver batch '$MANIFEST' '$RESULTS/shard_$SHARD' --shard $SHARD/$NUM_SHARDS $OPTIONS" \
+            > "$RESULTS/shard_$SHARD.log" 2>&1 &
+        SHARD=$((SHARD + 1))
+    done
+    wait
+else
+    NUM_SHARDS=$SHARDS
+    for SHARD in $(seq 0 $((NUM_SHARDS - 1))); do
+        echo "Shard $SHARD/$NUM_SHARDS"
+        ./posterior_driver batch "$MANIFEST" "$RESULTS/shard_$SHARD" --shard $SHARD/$NUM_SHARDS $OPTIONS \
+            > "$RESULTS/shard_$SHARD.log" 2>&1
+    done
+fi
+
+SHARD_DIRS=""
+for SHARD in $(seq 0 $((NUM_SHARDS - 1))); do
+    SHARD_DIRS="$SHARD_DIRS $RESULTS/shard_$SHARD"
+done
+./posterior_driver merge "$RESULTS/merged" $SHARD_DIRS
+echo "Report in $RESULTS/merged/report.txt"